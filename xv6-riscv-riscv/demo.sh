@@ -42,12 +42,12 @@ echo "对比结果:"
 echo ""
 
 # 提取并显示结果
-cow_no=$(grep "no-touch" cow_result.txt | grep -o 'total_ticks=[0-9]*' | cut -d'=' -f2)
-traditional_no=$(grep "no-touch" traditional_result.txt | grep -o 'total_ticks=[0-9]*' | cut -d'=' -f2)
-cow_small=$(grep "touch-1pages" cow_result.txt | grep -o 'total_ticks=[0-9]*' | cut -d'=' -f2)
-traditional_small=$(grep "touch-1pages" traditional_result.txt | grep -o 'total_ticks=[0-9]*' | cut -d'=' -f2)
-cow_big=$(grep "touch-128pages" cow_result.txt | grep -o 'total_ticks=[0-9]*' | cut -d'=' -f2)
-traditional_big=$(grep "touch-128pages" traditional_result.txt | grep -o 'total_ticks=[0-9]*' | cut -d'=' -f2)
+cow_no=$(grep "no-touch" cow_result.txt | grep -o 'total_ns=[0-9]*' | cut -d'=' -f2)
+traditional_no=$(grep "no-touch" traditional_result.txt | grep -o 'total_ns=[0-9]*' | cut -d'=' -f2)
+cow_small=$(grep "touch-1pages" cow_result.txt | grep -o 'total_ns=[0-9]*' | cut -d'=' -f2)
+traditional_small=$(grep "touch-1pages" traditional_result.txt | grep -o 'total_ns=[0-9]*' | cut -d'=' -f2)
+cow_big=$(grep "touch-128pages" cow_result.txt | grep -o 'total_ns=[0-9]*' | cut -d'=' -f2)
+traditional_big=$(grep "touch-128pages" traditional_result.txt | grep -o 'total_ns=[0-9]*' | cut -d'=' -f2)
 
 # 检查是否成功提取到数据
 if [ -z "$cow_no" ] || [ -z "$traditional_no" ]; then
@@ -61,6 +61,6 @@ if [ -z "$cow_no" ] || [ -z "$traditional_no" ]; then
     exit 1
 fi
 
-echo "no-touch (纯fork):   COW版本=$cow_no ticks, 传统版本=$traditional_no ticks"
-echo "touch-1pages (轻写): COW版本=$cow_small ticks, 传统版本=$traditional_small ticks"
-echo "touch-128pages (重写): COW版本=$cow_big ticks, 传统版本=$traditional_big ticks"
+echo "no-touch (纯fork):   COW版本=$cow_no ns, 传统版本=$traditional_no ns"
+echo "touch-1pages (轻写): COW版本=$cow_small ns, 传统版本=$traditional_small ns"
+echo "touch-128pages (重写): COW版本=$cow_big ns, 传统版本=$traditional_big ns"
@@ -22,6 +22,8 @@
 #include "defs.h"
 #include "fs.h"
 #include "buf.h"
+#include "sysinfo.h"
+#include "tracepoint.h"
 
 struct {
   struct spinlock lock;
@@ -31,6 +33,9 @@ struct {
   // Sorted by how recently the buffer was used.
   // head.next is most recent, head.prev is least.
   struct buf head;
+
+  uint64 nhit;    // bget found the block cached
+  uint64 nmiss;   // bget recycled a buffer
 } bcache;
 
 void
@@ -66,7 +71,9 @@ bget(uint dev, uint blockno)
   for(b = bcache.head.next; b != &bcache.head; b = b->next){
     if(b->dev == dev && b->blockno == blockno){
       b->refcnt++;
+      bcache.nhit++;
       release(&bcache.lock);
+      TP(TP_BGET_HIT, blockno, dev);
       acquiresleep(&b->lock);
       return b;
     }
@@ -80,7 +87,9 @@ bget(uint dev, uint blockno)
       b->blockno = blockno;
       b->valid = 0;
       b->refcnt = 1;
+      bcache.nmiss++;
       release(&bcache.lock);
+      TP(TP_BGET_MISS, blockno, dev);
       acquiresleep(&b->lock);
       return b;
     }
@@ -151,3 +160,13 @@ bunpin(struct buf *b) {
 }
 
 
+
+// Fill in the buffer cache part of a sysinfo snapshot.
+void
+bstat(struct sysinfo *si)
+{
+  acquire(&bcache.lock);
+  si->bcache_hits = bcache.nhit;
+  si->bcache_misses = bcache.nmiss;
+  release(&bcache.lock);
+}
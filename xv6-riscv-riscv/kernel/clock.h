@@ -0,0 +1,7 @@
+// 时钟频率信息，由 clockinfo() 系统调用返回给用户态。
+// 用户态直接用 rdtime/rdcycle 读取计数器（见 trapinithart 中的 scounteren），
+// 再用这里的频率换算成纳秒，不需要每次计时都陷入内核。
+struct clockinfo {
+  uint64 time_freq;   // time CSR 每秒计数（平台固定，TIMEBASE_FREQ）
+  uint64 cycle_freq;  // cycle CSR 每秒计数（启动时相对 time 校准）
+};
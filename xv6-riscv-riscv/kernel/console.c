@@ -58,7 +58,7 @@ struct {
 int
 consolewrite(int user_src, uint64 src, int n)
 {
-  char buf[32];
+  char buf[128];
   int i = 0;
 
   while(i < n){
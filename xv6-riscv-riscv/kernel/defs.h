@@ -1,13 +1,17 @@
 struct buf;
 struct context;
+struct cpu;
 struct file;
 struct inode;
 struct pipe;
 struct proc;
+struct ring;
 struct spinlock;
 struct sleeplock;
 struct stat;
 struct superblock;
+struct sysinfo;
+struct trapframe;
 
 // bio.c
 void            binit(void);
@@ -16,6 +20,7 @@ void            brelse(struct buf*);
 void            bwrite(struct buf*);
 void            bpin(struct buf*);
 void            bunpin(struct buf*);
+void            bstat(struct sysinfo*);
 
 // bcache_ext.c (thin wrappers)
 struct buffer_head; // alias to struct buf
@@ -32,6 +37,14 @@ void            consputc(int);
 // exec.c
 int             kexec(char*, char**);
 
+// fdtable.c
+struct file*    fdlookup(struct proc*, int);
+int             fdalloc(struct file*);
+void            fdclear(struct proc*, int);
+int             fdcopy(struct proc*, struct proc*);
+void            fdcloseall(struct proc*);
+int             fdsetlimit(struct proc*, int);
+
 // file.c
 struct file*    filealloc(void);
 void            fileclose(struct file*);
@@ -78,12 +91,14 @@ void            kinit(void);
 void            krefpage(void *);
 int             kunrefpage(void *);
 int             krefcount(void *);
+void            kmemstat(struct sysinfo*);
 
 // log.c
 void            initlog(int, struct superblock*);
 void            log_write(struct buf*);
 void            begin_op(void);
 void            end_op(void);
+void            logstat(struct sysinfo*);
 // wrappers
 void            log_init(int, struct superblock*);
 void            log_block_write(struct buf*);
@@ -103,17 +118,24 @@ int             pipewrite(struct pipe*, uint64, int);
 // printf.c
 int             printf(char*, ...) __attribute__ ((format (printf, 1, 2)));
 void            panic(char*) __attribute__((noreturn));
-void            printfinit(void);
+void            klog(int, char*, ...) __attribute__ ((format (printf, 2, 3)));
 
 // proc.c - 进程管理
 int             cpuid(void);
 void            kexit(int);
 int             kfork(void);
 int             growproc(int);
-void            proc_mapstacks(pagetable_t);
-pagetable_t     proc_pagetable(struct proc *);
+struct proc*    findproc(int);
+pagetable_t     proc_pagetable(struct trapframe *);
+int             uctxalloc(pagetable_t*, struct trapframe**);
+void            uctxfree(pagetable_t, struct trapframe*, uint64);
+void            uctxswap(pagetable_t, pagetable_t);
 void            proc_freepagetable(pagetable_t, uint64);
 int             kkill(int);
+int             kkillpg(int);
+int             ksetpgid(int, int);
+int             kgetpgid(int);
+int             ksetsid(void);
 int             killed(struct proc*);
 void            setkilled(struct proc*);
 struct cpu*     mycpu(void);
@@ -126,6 +148,7 @@ void            userinit(void);
 int             kwait(uint64);
 void            wakeup(void*);
 void            yield(void);
+int             schedtick(void);
 int             either_copyout(int user_dst, uint64 dst, void *src, uint64 len);
 int             either_copyin(void *dst, int user_src, uint64 src, uint64 len);
 void            procdump(void);
@@ -156,6 +179,7 @@ void            acquire(struct spinlock*);
 int             holding(struct spinlock*);
 void            initlock(struct spinlock*, char*);
 void            release(struct spinlock*);
+int             tryacquire(struct spinlock*);
 void            push_off(void);
 void            pop_off(void);
 
@@ -166,6 +190,10 @@ int             holdingsleep(struct sleeplock*);
 void            initsleeplock(struct sleeplock*, char*);
 
 // string.c
+void            copy_page(void*, const void*);
+void            zero_page(void*);
+void            copy_block(void*, const void*);
+void            zero_block(void*);
 int             memcmp(const void*, const void*, uint);
 void*           memmove(void*, const void*, uint);
 void*           memset(void*, int, uint);
@@ -182,9 +210,60 @@ int             fetchstr(uint64, char*, int);
 int             fetchaddr(uint64, uint64*);
 void            syscall();
 
+// ring.c
+void*           ring_reserve(struct ring*);
+void            ring_publish(struct ring*);
+uint64          ring_head(struct ring*, int);
+void*           ring_slot(struct ring*, int, uint64);
+int             ring_snapshot(struct ring*, int, uint64, void*);
+int             ring_read(struct ring*, uint64, int, uint64);
+
+// klog.c
+void            klog_commit(int, uint64, int, char*, int);
+int             klog_console(char*, int);
+int             klog_read(uint64, int);
+
+// trace.c
+void            trace_record(int, uint64*, uint64, uint64);
+int             traceread(uint64, int, uint64);
+
+// tracepoint.c
+extern uint64   tpmask;
+void            tp_record(int, uint64, uint64);
+int             tpctl(int);
+int             tpread(uint64, int, uint64);
+
+// static tracepoint; ev is a TP_xxx from tracepoint.h.
+#define TP(ev, a0, a1) do { \
+  if(tpmask & (1UL << (ev))) \
+    tp_record((ev), (uint64)(a0), (uint64)(a1)); \
+} while(0)
+
+// faultstat.c
+void            faultrecord(int, uint64);
+int             faultstat(int, uint64);
+uint64          faulttotal(void);
+
+// sysinfo.c
+int             sysinfo(uint64, int);
+
+// perf.c
+void            perfin(struct cpu*);
+void            perfout(struct cpu*, struct proc*);
+void            perfreap(struct proc*, struct proc*);
+int             perfstat(int, uint64);
+
+// prof.c
+uint64          profnext(uint64);
+void            profintr(uint64, uint64, uint64, int);
+int             profset(int);
+int             profread(uint64, int, uint64);
+
 // trap.c
 extern uint     ticks;
+extern uint64   cycle_freq;
 void            trapinit(void);
+void            clockcalibrate(void);
 void            trapinithart(void);
 extern struct spinlock tickslock;
 void            prepare_return(void);
@@ -194,6 +273,9 @@ void            uartinit(void);
 void            uartintr(void);
 void            uartwrite(char [], int);
 void            uartputc_sync(int);
+void            uartkick(void);
+int             uartdrain(void);
+void            uartpanicflush(void);
 int             uartgetc(void);
 
 // vm.c
@@ -206,6 +288,7 @@ uint64          uvmalloc(pagetable_t, uint64, uint64, int);
 uint64          uvmdealloc(pagetable_t, uint64, uint64);
 int             uvmcopy(pagetable_t, pagetable_t, uint64);
 void            uvmfree(pagetable_t, uint64);
+void            uvmreset(pagetable_t, uint64);
 void            uvmunmap(pagetable_t, uint64, uint64, int);
 void            uvmclear(pagetable_t, uint64);
 pte_t *         walk(pagetable_t, uint64, int);
@@ -216,6 +299,7 @@ int             copyinstr(pagetable_t, char *, uint64, uint64);
 int             ismapped(pagetable_t, uint64);
 uint64          vmfault(pagetable_t, uint64, int);
 int             cowhandler(pagetable_t, uint64);
+int             uvmfault(pagetable_t, uint64, int);
 
 // plic.c
 void            plicinit(void);
@@ -227,6 +311,7 @@ void            plic_complete(int);
 void            virtio_disk_init(void);
 void            virtio_disk_rw(struct buf *, int);
 void            virtio_disk_intr(void);
+void            diskstat(struct sysinfo*);
 
 // number of elements in fixed-size array
 #define NELEM(x) (sizeof(x)/sizeof((x)[0]))
@@ -33,6 +33,7 @@ kexec(char *path, char **argv)
   struct inode *ip;
   struct proghdr ph;
   pagetable_t pagetable = 0, oldpagetable;
+  struct trapframe *tf = 0;
   struct proc *p = myproc();
 
   begin_op();
@@ -52,8 +53,10 @@ kexec(char *path, char **argv)
   if(elf.magic != ELF_MAGIC)
     goto bad;
 
-  if((pagetable = proc_pagetable(p)) == 0)
+  if(uctxalloc(&pagetable, &tf) < 0){
+    pagetable = 0;
     goto bad;
+  }
 
   // Load program into memory.
   for(i=0, off=elf.phoff; i<elf.phnum; i++, off+=sizeof(ph)){
@@ -127,19 +130,22 @@ kexec(char *path, char **argv)
       last = s+1;
   safestrcpy(p->name, last, sizeof(p->name));
     
-  // Commit to the user image.
+  // Commit to the user image. p->trapframe moves over to the
+  // new page table, and the spare trapframe from the cache
+  // goes back with the old one.
   oldpagetable = p->pagetable;
+  uctxswap(pagetable, oldpagetable);
   p->pagetable = pagetable;
   p->sz = sz;
   p->trapframe->epc = elf.entry;  // initial program counter = ulib.c:start()
   p->trapframe->sp = sp; // initial stack pointer
-  proc_freepagetable(oldpagetable, oldsz);
+  uctxfree(oldpagetable, tf, oldsz);
 
   return argc; // this ends up in a0, the first argument to main(argc, argv)
 
  bad:
   if(pagetable)
-    proc_freepagetable(pagetable, sz);
+    uctxfree(pagetable, tf, sz);
   if(ip){
     iunlockput(ip);
     end_op();
@@ -0,0 +1,127 @@
+// kernel/faultstat.c - 页错误统计
+
+//
+// 功能：
+// - 按类别统计页错误：COW 复制、COW 复用、惰性清零、伪错误
+//   （见 faultstat.h），记录次数和处理耗时
+// - 每个进程有自己的次数和耗时；全局统计还有耗时直方图
+// - 通过 faultstat() 系统调用导出，基准测试可以据此把时间
+//   归到页错误路径上
+//
+// 并发：
+// - 进程统计只由进程自己在陷入内核时更新
+// - 全局统计按 CPU 分开，更新时关中断，读出时求和；
+//   读到的是近似快照，不保证各项之间完全一致
+//
+
+#include "types.h"
+#include "param.h"
+#include "memlayout.h"
+#include "riscv.h"
+#include "spinlock.h"
+#include "proc.h"
+#include "defs.h"
+#include "errno.h"
+#include "faultstat.h"
+
+static struct faultstat cpustat[NCPU] __attribute__((aligned(64)));
+
+// 耗时 c 所在的直方图桶
+static int
+bucket(uint64 c)
+{
+  int b = 0;
+
+  c >>= FAULT_HISTSHIFT + 1;
+  while(c && b < FAULT_NBUCKET - 1){
+    c >>= 1;
+    b++;
+  }
+  return b;
+}
+
+// faultrecord - 记录一次页错误处理
+//
+// 参数：
+//   type:   FAULT_xxx
+//   cycles: 处理耗时（r_cycle() 之差）
+//
+void
+faultrecord(int type, uint64 cycles)
+{
+  struct faultstat *s;
+  struct proc *p = myproc();
+
+  push_off();
+  s = &cpustat[cpuid()];
+  s->count[type]++;
+  s->cycles[type] += cycles;
+  s->hist[type][bucket(cycles)]++;
+  pop_off();
+
+  if(p){
+    p->faultcnt[type]++;
+    p->faultcycles[type] += cycles;
+  }
+}
+
+// faulttotal - 全局页错误总次数（各类之和），供 sysinfo 使用
+//
+uint64
+faulttotal(void)
+{
+  uint64 n = 0;
+
+  for(int c = 0; c < NCPU; c++)
+    for(int t = 0; t < NFAULTTYPE; t++)
+      n += cpustat[c].count[t];
+  return n;
+}
+
+// faultstat - 把统计复制到用户空间
+//
+// 参数：
+//   pid:  FAULTSTAT_ALL 取全局统计，FAULTSTAT_SELF 取当前进程，
+//         其他值取该 pid 的进程（直方图为 0）
+//   addr: 用户空间的 struct faultstat
+//
+// 返回值：0，或 -ESRCH / -EFAULT
+//
+int
+faultstat(int pid, uint64 addr)
+{
+  struct faultstat st;
+  struct proc *p = myproc();
+  int c, t, b;
+
+  memset(&st, 0, sizeof(st));
+  if(pid == FAULTSTAT_ALL){
+    for(c = 0; c < NCPU; c++){
+      for(t = 0; t < NFAULTTYPE; t++){
+        st.count[t] += cpustat[c].count[t];
+        st.cycles[t] += cpustat[c].cycles[t];
+        for(b = 0; b < FAULT_NBUCKET; b++)
+          st.hist[t][b] += cpustat[c].hist[t][b];
+      }
+    }
+  } else if(pid == FAULTSTAT_SELF){
+    for(t = 0; t < NFAULTTYPE; t++){
+      st.count[t] = p->faultcnt[t];
+      st.cycles[t] = p->faultcycles[t];
+    }
+  } else {
+    // 持有 q->lock 时 q 不会被回收，读到的是它自己的计数
+    struct proc *q = findproc(pid);
+    if(q == 0)
+      return -ESRCH;
+    for(t = 0; t < NFAULTTYPE; t++){
+      st.count[t] = q->faultcnt[t];
+      st.cycles[t] = q->faultcycles[t];
+    }
+    release(&q->lock);
+  }
+
+  if(copyout(p->pagetable, addr, (char *)&st, sizeof(st)) < 0)
+    return -EFAULT;
+  return 0;
+}
@@ -0,0 +1,25 @@
+// 页错误统计，内核 faultstat.c 记录，用户态 faultstat() 读出。
+//
+// 每次用户页错误（以及 copyout/copyin 代替用户触发的同类处理）
+// 按处理结果归为一类，记录次数和处理耗时（cycle 计数器）。
+// 全局统计另有按耗时的 log2 直方图。
+//
+// 需要先包含 param.h（NFAULTTYPE）。
+//
+#define FAULT_COW_COPY   0     // COW 页被共享，复制一份
+#define FAULT_COW_REUSE  1     // COW 页已无人共享，直接恢复可写
+#define FAULT_LAZY       2     // 惰性分配的页，分配并清零
+#define FAULT_SPURIOUS   3     // 页表已允许该访问，无需处理
+
+#define FAULT_NBUCKET    16    // 直方图桶数
+#define FAULT_HISTSHIFT  8     // 桶 0 是 [0, 512) 个 cycle，
+                               // 桶 i 是 [2^(i+8), 2^(i+9))，最后一桶不封顶
+
+#define FAULTSTAT_SELF   0     // faultstat() 的 pid：当前进程
+#define FAULTSTAT_ALL    (-1)  // faultstat() 的 pid：全局
+
+struct faultstat {
+  uint64 count[NFAULTTYPE];                  // 次数
+  uint64 cycles[NFAULTTYPE];                 // 总耗时（cycle）
+  uint64 hist[NFAULTTYPE][FAULT_NBUCKET];    // 耗时分布，只有全局统计有
+};
@@ -0,0 +1,232 @@
+// kernel/fdtable.c - 可增长的进程文件描述符表
+
+//
+// 功能：
+// - 每个进程的 fd 表由最多 NFDPAGE 个页组成，用到时才分配，
+//   每页容纳 FDPERPAGE 个 struct file 指针，共 FDMAX 个 fd
+// - 每页带一个占用位图，p->fdfull 记录哪些页已经占满：
+//   分配最小的空闲 fd 只需先在 fdfull 中、再在页内位图中
+//   找第一个 0 位，代价与已打开的 fd 数量无关
+// - 每个进程有自己的上限 p->fdlimit（默认 NOFILE），
+//   可用 fdlimit() 系统调用调整，fork 时继承
+//
+// 并发：
+// - fd 表只由所属进程自己访问（系统调用、fork、exit），不需要加锁
+//
+
+#include "types.h"
+#include "param.h"
+#include "riscv.h"
+#include "spinlock.h"
+#include "proc.h"
+#include "defs.h"
+#include "errno.h"
+
+#define FDMAPWORDS  8   // 页内位图的字数（512 位，够 FDPERPAGE 用）
+#define FDPERPAGE   ((int)((PGSIZE - FDMAPWORDS * 8) / sizeof(struct file*)))
+#define FDMAX       (NFDPAGE * FDPERPAGE)
+
+// 一页 fd 表：位图之后紧跟指针数组，正好占满一页
+struct fdpage {
+  uint64 used[FDMAPWORDS];         // 位 i 置位表示 f[i] 已占用
+  struct file *f[FDPERPAGE];
+};
+
+
+// firstzero - 返回 x 中最低的 0 位的序号（x 不能全为 1）
+//
+// 不用 __builtin_ctzl：没有 Zbb 扩展时它会变成对 libgcc 的调用，
+// 而内核不链接 libgcc
+//
+static int
+firstzero(uint64 x)
+{
+  int n = 0;
+
+  x = ~x;
+  if((x & 0xffffffff) == 0){ n += 32; x >>= 32; }
+  if((x & 0xffff) == 0){ n += 16; x >>= 16; }
+  if((x & 0xff) == 0){ n += 8; x >>= 8; }
+  if((x & 0xf) == 0){ n += 4; x >>= 4; }
+  if((x & 0x3) == 0){ n += 2; x >>= 2; }
+  if((x & 0x1) == 0)
+    n += 1;
+  return n;
+}
+
+// fdpagealloc - 分配一个空的 fd 表页
+//
+// 位图中超出 FDPERPAGE 的位预先置 1，使它们永远不会被分配
+//
+static struct fdpage*
+fdpagealloc(void)
+{
+  struct fdpage *pg;
+
+  if((pg = (struct fdpage*)kalloc()) == 0)
+    return 0;
+  zero_page(pg);
+  pg->used[FDMAPWORDS - 1] = ~0UL << (FDPERPAGE % 64);
+  return pg;
+}
+
+static int
+fdpagefull(struct fdpage *pg)
+{
+  for(int w = 0; w < FDMAPWORDS; w++)
+    if(~pg->used[w])
+      return 0;
+  return 1;
+}
+
+
+// fdlookup - 查找进程 p 的文件描述符 fd
+//
+// 返回值：对应的 struct file，fd 无效或未打开时返回 0
+//
+// 注意：不检查 fdlimit，调低上限不影响已经打开的 fd
+//
+struct file*
+fdlookup(struct proc *p, int fd)
+{
+  struct fdpage *pg;
+
+  if(fd < 0 || fd >= FDMAX)
+    return 0;
+  if((pg = p->fdtab[fd / FDPERPAGE]) == 0)
+    return 0;
+  return pg->f[fd % FDPERPAGE];
+}
+
+// fdalloc - 为当前进程分配最小的空闲 fd，并让它指向 f
+//
+// 成功时接管调用者持有的 f 的引用
+//
+// 返回值：
+// - 成功：新的 fd
+// - -EMFILE：最小的空闲 fd 不小于 fdlimit
+// - -ENOMEM：需要新的表页但内存不足
+//
+int
+fdalloc(struct file *f)
+{
+  struct proc *p = myproc();
+  struct fdpage *pg;
+  int i, w, slot, fd;
+
+  i = firstzero(p->fdfull);          // 第一个未满的页
+  if(i >= NFDPAGE || i * FDPERPAGE >= p->fdlimit)
+    return -EMFILE;
+  if((pg = p->fdtab[i]) == 0){
+    if((pg = fdpagealloc()) == 0)
+      return -ENOMEM;
+    p->fdtab[i] = pg;
+  }
+
+  for(w = 0; pg->used[w] == ~0UL; w++)   // 页未满，一定能找到
+    ;
+  slot = w * 64 + firstzero(pg->used[w]);
+  fd = i * FDPERPAGE + slot;
+  if(fd >= p->fdlimit)
+    return -EMFILE;
+
+  pg->used[w] |= 1UL << (slot % 64);
+  pg->f[slot] = f;
+  if(fdpagefull(pg))
+    p->fdfull |= 1UL << i;
+  return fd;
+}
+
+// fdclear - 释放进程 p 的 fd 槽位（不关闭文件）
+//
+// 前提：fd 已打开（由 fdlookup 或 fdalloc 得到）
+//
+void
+fdclear(struct proc *p, int fd)
+{
+  struct fdpage *pg = p->fdtab[fd / FDPERPAGE];
+  int slot = fd % FDPERPAGE;
+
+  pg->f[slot] = 0;
+  pg->used[slot / 64] &= ~(1UL << (slot % 64));
+  p->fdfull &= ~(1UL << (fd / FDPERPAGE));
+}
+
+// fdcopy - fork 时把 p 的 fd 表复制给 np
+//
+// 父子进程共享打开的文件，每个文件的引用计数加 1；
+// 同时继承 fdlimit
+//
+// 返回值：成功返回 0；内存不足返回 -1，此时 np 的表保持为空
+//
+int
+fdcopy(struct proc *np, struct proc *p)
+{
+  struct fdpage *pg;
+  int i, slot;
+
+  for(i = 0; i < NFDPAGE; i++){
+    if(p->fdtab[i] == 0)
+      continue;
+    if((np->fdtab[i] = (struct fdpage*)kalloc()) == 0){
+      while(--i >= 0){
+        if(np->fdtab[i])
+          kfree(np->fdtab[i]);
+        np->fdtab[i] = 0;
+      }
+      return -1;
+    }
+  }
+
+  // 页都到手之后才增加引用，失败路径不必关闭文件
+  for(i = 0; i < NFDPAGE; i++){
+    if((pg = p->fdtab[i]) == 0)
+      continue;
+    copy_page(np->fdtab[i], pg);
+    for(slot = 0; slot < FDPERPAGE; slot++)
+      if(pg->f[slot])
+        filedup(pg->f[slot]);
+  }
+  np->fdfull = p->fdfull;
+  np->fdlimit = p->fdlimit;
+  return 0;
+}
+
+// fdcloseall - 进程退出时关闭所有打开的文件并释放 fd 表
+//
+void
+fdcloseall(struct proc *p)
+{
+  struct fdpage *pg;
+  int i, slot;
+
+  for(i = 0; i < NFDPAGE; i++){
+    if((pg = p->fdtab[i]) == 0)
+      continue;
+    for(slot = 0; slot < FDPERPAGE; slot++)
+      if(pg->f[slot])
+        fileclose(pg->f[slot]);   // 减少引用计数，可能触发文件关闭
+    p->fdtab[i] = 0;
+    kfree(pg);
+  }
+  p->fdfull = 0;
+}
+
+// fdsetlimit - 设置进程 p 的打开文件数上限
+//
+// 参数：
+//   n: 新上限，1 到 FDMAX；0 表示只查询
+//
+// 返回值：原来的上限，或 -EINVAL
+//
+int
+fdsetlimit(struct proc *p, int n)
+{
+  int old = p->fdlimit;
+
+  if(n < 0 || n > FDMAX)
+    return -EINVAL;
+  if(n > 0)
+    p->fdlimit = n;
+  return old;
+}
@@ -14,9 +14,15 @@
 #include "proc.h"
 
 struct devsw devsw[NDEV];
+
+// struct files are carved out of whole pages when the free
+// list runs dry, so filealloc() and fileclose() are O(1).
+// pages are never given back; NFILE bounds how many files
+// can be open at once.
 struct {
   struct spinlock lock;
-  struct file file[NFILE];
+  struct file *free;  // free list, linked through next
+  int nfile;          // files in use
 } ftable;
 
 void
@@ -25,22 +31,41 @@ fileinit(void)
   initlock(&ftable.lock, "ftable");
 }
 
+// Put a fresh page of file structures on the free list.
+// Caller holds ftable.lock.
+static void
+filegrow(void)
+{
+  struct file *f;
+  int i;
+
+  if((f = (struct file*)kalloc()) == 0)
+    return;
+  zero_page(f);
+  for(i = 0; i < PGSIZE / sizeof(struct file); i++){
+    f[i].next = ftable.free;
+    ftable.free = &f[i];
+  }
+}
+
 // Allocate a file structure.
 struct file*
 filealloc(void)
 {
-  struct file *f;
+  struct file *f = 0;
 
   acquire(&ftable.lock);
-  for(f = ftable.file; f < ftable.file + NFILE; f++){
-    if(f->ref == 0){
+  if(ftable.nfile < NFILE){
+    if(ftable.free == 0)
+      filegrow();
+    if((f = ftable.free) != 0){
+      ftable.free = f->next;
+      ftable.nfile++;
       f->ref = 1;
-      release(&ftable.lock);
-      return f;
     }
   }
   release(&ftable.lock);
-  return 0;
+  return f;
 }
 
 // Increment ref count for file f.
@@ -71,6 +96,9 @@ fileclose(struct file *f)
   ff = *f;
   f->ref = 0;
   f->type = FD_NONE;
+  f->next = ftable.free;
+  ftable.free = f;
+  ftable.nfile--;
   release(&ftable.lock);
 
   if(ff.type == FD_PIPE){
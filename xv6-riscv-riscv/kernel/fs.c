@@ -69,7 +69,7 @@ bzero(int dev, int bno)
   struct buf *bp;
 
   bp = bread(dev, bno);
-  memset(bp->data, 0, BSIZE);
+  zero_block(bp->data);
   log_block_write(bp);
   brelse(bp);
 }
@@ -8,6 +8,8 @@
 #include "spinlock.h"
 #include "riscv.h"
 #include "defs.h"
+#include "sysinfo.h"
+#include "tracepoint.h"
 
 void freerange(void *pa_start, void *pa_end);
 
@@ -21,12 +23,15 @@ struct run {
 struct {
   struct spinlock lock;
   struct run *freelist;
+  uint64 nfree;   // pages on freelist
+  uint64 ntotal;  // pages handed to the allocator at boot
 } kmem;
 
 // COW: Reference counting for physical pages
 struct {
   struct spinlock lock;
   int count[PHYSTOP / PGSIZE];  // Reference count for each physical page
+  uint64 nshared;               // pages with count > 1
 } pg_refcnt;
 
 void
@@ -35,6 +40,7 @@ kinit()
   initlock(&kmem.lock, "kmem");
   initlock(&pg_refcnt.lock, "pg_refcnt");
   freerange(end, (void*)PHYSTOP);
+  kmem.ntotal = kmem.nfree;
 }
 
 // Get page index from physical address
@@ -52,7 +58,8 @@ krefpage(void *pa)
     return;
     
   acquire(&pg_refcnt.lock);
-  pg_refcnt.count[pa2idx((uint64)pa)]++;
+  if(++pg_refcnt.count[pa2idx((uint64)pa)] == 2)
+    pg_refcnt.nshared++;
   release(&pg_refcnt.lock);
 }
 
@@ -71,7 +78,8 @@ kunrefpage(void *pa)
     panic("kunrefpage: refcount < 1");
   }
   
-  pg_refcnt.count[idx]--;
+  if(pg_refcnt.count[idx]-- == 2)
+    pg_refcnt.nshared--;
   int should_free = (pg_refcnt.count[idx] == 0);
   release(&pg_refcnt.lock);
   
@@ -116,6 +124,8 @@ kfree(void *pa)
   if(((uint64)pa % PGSIZE) != 0 || (char*)pa < end || (uint64)pa >= PHYSTOP)
     panic("kfree");
 
+  TP(TP_KFREE, pa, 0);
+
   // COW: Set reference count to 0
   acquire(&pg_refcnt.lock);
   pg_refcnt.count[pa2idx((uint64)pa)] = 0;
@@ -129,6 +139,7 @@ kfree(void *pa)
   acquire(&kmem.lock);
   r->next = kmem.freelist;
   kmem.freelist = r;
+  kmem.nfree++;
   release(&kmem.lock);
 }
 
@@ -142,8 +153,10 @@ kalloc(void)
 
   acquire(&kmem.lock);
   r = kmem.freelist;
-  if(r)
+  if(r){
     kmem.freelist = r->next;
+    kmem.nfree--;
+  }
   release(&kmem.lock);
 
   if(r) {
@@ -153,7 +166,22 @@ kalloc(void)
     acquire(&pg_refcnt.lock);
     pg_refcnt.count[pa2idx((uint64)r)] = 1;
     release(&pg_refcnt.lock);
+    TP(TP_KALLOC, r, 0);
   }
   
   return (void*)r;
 }
+
+// Fill in the memory part of a sysinfo snapshot.
+void
+kmemstat(struct sysinfo *si)
+{
+  acquire(&kmem.lock);
+  si->mem_total = kmem.ntotal;
+  si->mem_free = kmem.nfree;
+  release(&kmem.lock);
+
+  acquire(&pg_refcnt.lock);
+  si->mem_shared = pg_refcnt.nshared;
+  release(&pg_refcnt.lock);
+}
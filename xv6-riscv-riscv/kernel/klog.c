@@ -0,0 +1,231 @@
+
+// kernel/klog.c - 每 CPU 无锁内核日志环
+
+//
+// 功能：
+// - printf()/klog() 把格式化好的正文写入本 CPU 的日志环，立即返回
+// - 串口驱动在发送空闲时调用 klog_console() 取走正文（异步输出）
+// - 环中写满了控制台还没取走的正文时，写入端调用 uartdrain()
+//   同步输出腾出位置；tx_lock 正被其他 CPU 持有时只能覆盖，
+//   控制台会在原位置输出 "klog: N records dropped" 提示
+// - dmesg() 系统调用不破坏地读出各环中仍保留的记录
+//
+// 为什么不直接输出到串口？
+// - 原实现所有 CPU 都在 pr.lock 上排队，逐字节忙等 uartputc_sync，
+//   调试输出多时会拖住整个系统
+//
+// 写入端：
+// - 每 CPU 无锁环（见 ring.c），写入时关中断
+//
+// 读出端：
+// - 不用 ring_read：控制台和 dmesg 各自按序号读，互不消耗
+// - 控制台游标 con/coff 只在持有 uart 的 tx_lock 时推进
+// - 多个环按时间戳归并，保证控制台输出基本按时间顺序
+// - panic 时由 uartpanicflush() 在不加锁的情况下同步读出
+//
+
+#include "types.h"
+#include "param.h"
+#include "memlayout.h"
+#include "riscv.h"
+#include "spinlock.h"
+#include "proc.h"
+#include "defs.h"
+#include "klog.h"
+#include "ring.h"
+
+extern volatile int panicking;  // from printf.c
+
+static struct klogent klogents[NCPU][KLOG_NENT] __attribute__((aligned(64)));
+static struct ring klogring = RING_INIT(klogents);
+
+static struct {
+  uint64 con;         // 控制台下一条要输出的记录序号
+  uint coff;          // 该记录中已输出的字节数
+} cons[NCPU];
+
+static int concur = -1;   // 正在输出（coff > 0 或等待 KLOG_MORE 的后续）的环，-1 表示无
+static uint64 ndrop;      // 控制台跳过、尚未提示的记录数
+static char dropmsg[48];  // 正在输出的丢失提示
+static int droplen, dropoff;
+
+
+// klog_commit - 把一段正文写入本 CPU 的日志环
+//
+// 参数：
+//   level: KLOG_xxx
+//   ts:    时间戳，同一次 printf 拆出的记录用同一个
+//   flags: KLOG_MORE 表示还有后续记录
+//   s, n:  正文及长度（n <= KLOG_TEXT）
+//
+void
+klog_commit(int level, uint64 ts, int flags, char *s, int n)
+{
+  struct klogent *e;
+  int cpu;
+
+  push_off();
+  cpu = cpuid();
+
+  // 要写的槽位还没送到控制台：先同步输出。con 只增不减，
+  // 读到旧值只会多做一次 drain
+  if(ring_head(&klogring, cpu) - __atomic_load_n(&cons[cpu].con, __ATOMIC_RELAXED) >= KLOG_NENT)
+    uartdrain();
+
+  e = ring_reserve(&klogring);
+  e->ts = ts;
+  e->level = level;
+  e->flags = flags;
+  e->cpu = cpu;
+  e->len = n;
+  memmove(e->text, s, n);
+  ring_publish(&klogring);
+  pop_off();
+}
+
+// 生成丢失提示 "klog: N records dropped\n"
+static void
+fmtdrop(uint64 n)
+{
+  char num[20];
+  char *s;
+  int i = 0;
+
+  droplen = dropoff = 0;
+  for(s = "klog: "; *s; s++)
+    dropmsg[droplen++] = *s;
+  do {
+    num[i++] = '0' + n % 10;
+  } while((n /= 10) != 0);
+  while(--i >= 0)
+    dropmsg[droplen++] = num[i];
+  for(s = " records dropped\n"; *s; s++)
+    dropmsg[droplen++] = *s;
+}
+
+
+// klog_console - 取出尚未输出到控制台的正文
+//
+// 参数：
+//   dst, n: 目标缓冲区及容量
+//
+// 返回值：复制的字节数，0 表示没有待输出的正文
+//
+// 调用者负责互斥（uart.c 中持有 tx_lock，或 panic 时单线程）
+// 被覆盖的旧记录跳过，并在两条记录之间输出一行丢失提示
+//
+// 带 KLOG_MORE 的记录输出完后留在同一个环上，接着输出同一次
+// printf 的后续记录；后续记录还没发布时（写者正在关中断格式化）
+// 先返回，下次再从这里继续，避免其他 CPU 的正文插到一行中间。
+// panic 时不再等待
+//
+int
+klog_console(char *dst, int n)
+{
+  struct klogent e;
+  int got = 0;
+
+  while(got < n){
+    int c = concur;
+
+    // 先把丢失提示输出完
+    if(c < 0 && dropoff < droplen){
+      int m = droplen - dropoff;
+      if(m > n - got)
+        m = n - got;
+      memmove(dst + got, dropmsg + dropoff, m);
+      got += m;
+      dropoff += m;
+      continue;
+    }
+
+    // 没有输出到一半的记录：选时间戳最早的待输出记录
+    if(c < 0){
+      uint64 best = 0;
+      for(int k = 0; k < NCPU; k++){
+        uint64 head = ring_head(&klogring, k);
+        if(head - cons[k].con > KLOG_NENT){
+          ndrop += head - KLOG_NENT - cons[k].con;
+          cons[k].con = head - KLOG_NENT;
+        }
+        if(cons[k].con == head)
+          continue;
+        uint64 ts = ((struct klogent *)ring_slot(&klogring, k, cons[k].con))->ts;
+        if(c < 0 || ts < best){
+          c = k;
+          best = ts;
+        }
+      }
+      if(ndrop > 0){
+        fmtdrop(ndrop);
+        ndrop = 0;
+        continue;
+      }
+      if(c < 0)
+        break;
+    }
+
+    // 等待同一次 printf 的后续记录
+    if(cons[c].con == ring_head(&klogring, c)){
+      if(!panicking)
+        break;
+      concur = -1;
+      continue;
+    }
+
+    if(ring_snapshot(&klogring, c, cons[c].con, &e) < 0){
+      ndrop++;
+      cons[c].con++;
+      cons[c].coff = 0;
+      concur = -1;
+      continue;
+    }
+    int m = e.len - cons[c].coff;
+    if(m > n - got)
+      m = n - got;
+    memmove(dst + got, e.text + cons[c].coff, m);
+    got += m;
+    cons[c].coff += m;
+    if(cons[c].coff >= e.len){
+      cons[c].con++;
+      cons[c].coff = 0;
+      concur = (e.flags & KLOG_MORE) ? c : -1;
+    } else {
+      concur = c;
+    }
+  }
+  return got;
+}
+
+
+// klog_read - 把各环中仍保留的记录复制到用户空间（不消耗记录）
+//
+// 参数：
+//   ubuf: 用户缓冲区（struct klogent 数组）
+//   n:    缓冲区容量（记录数）
+//
+// 返回值：
+//   >= 0: 复制的记录数（按 CPU 分组，组内按时间顺序）
+//   -1:   用户地址非法
+//
+int
+klog_read(uint64 ubuf, int n)
+{
+  struct proc *p = myproc();
+  struct klogent e;
+  int cnt = 0;
+
+  for(int c = 0; c < NCPU && cnt < n; c++){
+    uint64 head = ring_head(&klogring, c);
+    uint64 i = head > KLOG_NENT ? head - KLOG_NENT : 0;
+
+    for(; i < head && cnt < n; i++){
+      if(ring_snapshot(&klogring, c, i, &e) < 0)
+        continue;
+      if(copyout(p->pagetable, ubuf + cnt * sizeof(e), (char *)&e, sizeof(e)) < 0)
+        return -1;
+      cnt++;
+    }
+  }
+  return cnt;
+}
@@ -0,0 +1,30 @@
+// 内核日志记录，内核 klog.c 写入，用户态 dmesg() 读出。
+//
+// 每次 printf()/klog() 生成一条或多条记录（正文超过 KLOG_TEXT
+// 时拆分），正文不以 '\0' 结尾，长度见 len。拆分出的记录在同一
+// CPU 的环中连续存放、时间戳相同，除最后一条外都带 KLOG_MORE。
+//
+// 时间戳单位是 time 计数器的 tick（频率见 clockinfo()）。
+//
+#define KLOG_NENT    64        // 每个 CPU 的环形缓冲区记录数（2 的幂）
+#define KLOG_TEXT    112       // 每条记录的正文字节数
+
+// 日志级别（数值与 syslog 一致，越小越严重）
+#define KLOG_EMERG   0         // 系统不可用（panic）
+#define KLOG_ERR     3         // 错误
+#define KLOG_WARN    4         // 警告
+#define KLOG_INFO    6         // 普通信息（printf 的默认级别）
+#define KLOG_DEBUG   7         // 调试信息
+
+// flags
+#define KLOG_MORE    1         // 同一次 printf 还有后续记录
+
+struct klogent {
+  uint64 ts;              // 写入时的 r_time()
+  uchar level;            // KLOG_xxx
+  uchar cpu;              // 写入的 CPU
+  ushort len;             // 正文长度
+  uchar flags;            // KLOG_MORE
+  uchar pad[3];
+  char text[KLOG_TEXT];   // 正文
+};
@@ -6,6 +6,8 @@
 #include "sleeplock.h"
 #include "fs.h"
 #include "buf.h"
+#include "sysinfo.h"
+#include "tracepoint.h"
 
 // Simple logging that allows concurrent FS system calls.
 //
@@ -44,6 +46,11 @@ struct log {
   int committing;  // in commit(), please wait.
   int dev;
   struct logheader lh;
+
+  // statistics, protected by lock except where noted.
+  uint64 ncommit;  // transactions written; updated by the committer
+  uint64 nblock;   // blocks written through the log; ditto
+  uint64 nwait;    // times begin_op had to sleep
 };
 struct log log;
 
@@ -127,7 +134,7 @@ install_trans(int recovering)
     }
     struct buf *lbuf = bread(log.dev, log.start+tail+1); // read log block
     struct buf *dbuf = bread(log.dev, log.lh.block[tail]); // read dst
-    memmove(dbuf->data, lbuf->data, BSIZE);  // copy block to dst
+    copy_block(dbuf->data, lbuf->data);  // copy block to dst
     bwrite(dbuf);  // write dst to disk
     if(recovering == 0)
       bunpin(dbuf);
@@ -180,16 +187,24 @@ recover_from_log(void)
 void
 begin_op(void)
 {
+  int waits = 0;
+
+  TP(TP_BEGIN_OP, 0, 0);
   acquire(&log.lock);
   while(1){
     if(log.committing){
+      log.nwait++;
+      waits++;
       sleep(&log, &log.lock);
     } else if(log.lh.n + (log.outstanding+1)*MAXOPBLOCKS > LOGBLOCKS){
       // this op might exhaust log space; wait for commit.
+      log.nwait++;
+      waits++;
       sleep(&log, &log.lock);
     } else {
       log.outstanding += 1;
       release(&log.lock);
+      TP(TP_BEGIN_OP_DONE, waits, 0);
       break;
     }
   }
@@ -237,7 +252,7 @@ write_log(void)
   for (tail = 0; tail < log.lh.n; tail++) {
     struct buf *to = bread(log.dev, log.start+tail+1); // log block
     struct buf *from = bread(log.dev, log.lh.block[tail]); // cache block
-    memmove(to->data, from->data, BSIZE);
+    copy_block(to->data, from->data);
     bwrite(to);  // write the log
     brelse(from);
     brelse(to);
@@ -248,9 +263,13 @@ static void
 commit()
 {
   if (log.lh.n > 0) {
+    TP(TP_COMMIT, log.lh.n, 0);
     write_log();     // Write modified blocks from cache to log
     write_head();    // Write header to disk -- the real commit
     install_trans(0); // Now install writes to home locations
+    log.ncommit++;    // log.committing keeps other writers out
+    log.nblock += log.lh.n;
+    TP(TP_COMMIT_DONE, log.lh.n, 0);
     log.lh.n = 0;
     write_head();    // Erase the transaction from the log
   }
@@ -288,3 +307,14 @@ log_write(struct buf *b)
   release(&log.lock);
 }
 
+
+// Fill in the log part of a sysinfo snapshot.
+void
+logstat(struct sysinfo *si)
+{
+  acquire(&log.lock);
+  si->log_commits = log.ncommit;
+  si->log_blocks = log.nblock;
+  si->log_waits = log.nwait;
+  release(&log.lock);
+}
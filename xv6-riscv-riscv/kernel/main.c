@@ -12,7 +12,6 @@ main()
 {
   if(cpuid() == 0){
     consoleinit();
-    printfinit();
     printf("\n");
     printf("\n");
     kinit();         // physical page allocator
@@ -20,6 +19,7 @@ main()
     kvminithart();   // turn on paging
     procinit();      // process table
     trapinit();      // trap vectors
+    clockcalibrate(); // measure cycle counter frequency
     trapinithart();  // install kernel trap vector
     plicinit();      // set up interrupt controller
     plicinithart();  // ask PLIC for device interrupts
@@ -17,6 +17,9 @@
 // end -- start of kernel page allocation area
 // PHYSTOP -- end RAM used by the kernel
 
+// qemu virt's CLINT advances the time CSR at 10 MHz.
+#define TIMEBASE_FREQ 10000000L
+
 // qemu puts UART registers here in physical memory.
 #define UART0 0x10000000L
 #define UART0_IRQ 10
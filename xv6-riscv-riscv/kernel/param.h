@@ -1,7 +1,8 @@
-#define NPROC        64  // maximum number of processes
+#define NPROC      4096  // maximum number of processes
 #define NCPU          8  // maximum number of CPUs
-#define NOFILE       16  // open files per process
-#define NFILE       100  // open files per system
+#define NOFILE       16  // default open files per process (see fdlimit)
+#define NFDPAGE      16  // max fd table pages per process, 504 fds each
+#define NFILE      8192  // open files per system
 #define NINODE       50  // maximum number of active i-nodes
 #define NDEV         10  // maximum major device number
 #define ROOTDEV       1  // device number of file system root disk
@@ -12,4 +13,7 @@
 #define FSSIZE       12000  // size of file system in blocks
 #define MAXPATH      128   // maximum file path name
 #define USERSTACK    1     // user stack pages
+#define NFAULTTYPE   4     // page fault kinds counted (see faultstat.h)
+#define NPERFCTR     5     // hardware counters virtualized per process (see perf.h)
+#define QUANTUM      1     // ticks a process runs before preemption, outside MLFQ
 
@@ -0,0 +1,117 @@
+// kernel/perf.c - 按进程虚拟化的硬件性能计数器
+
+//
+// 功能：
+// - cycle、instret 和 hpmcounter3..5（事件在 start.c 的
+//   counterinit 中选择）在每个 CPU 上一直计数
+// - 调度器切换到进程前用 perfin 记下各计数器的值，
+//   进程切回调度器后用 perfout 把差值累加到 p->perf
+// - 子进程被 wait 回收时，它自己和它的子孙的计数
+//   并入父进程的 p->perfchild，与 getrusage 的 RUSAGE_CHILDREN 相同
+// - 通过 perf_stat() 系统调用导出（见 perf.h），
+//   用户可以不改内核就算出自己代码的 IPC
+//
+// 并发：
+// - p->perf 只在调度器中持有 p->lock 时修改
+// - p->perfchild 只由进程自己在 wait 中修改
+//
+// 开销：
+// - 每次切换多读两次 5 个 CSR
+//
+
+#include "types.h"
+#include "param.h"
+#include "memlayout.h"
+#include "riscv.h"
+#include "spinlock.h"
+#include "proc.h"
+#include "defs.h"
+#include "errno.h"
+#include "perf.h"
+
+// 读本 CPU 的所有计数器
+static void
+perfread(uint64 *v)
+{
+  v[PERF_CYCLES] = r_cycle();
+  v[PERF_INSTRET] = r_instret();
+  v[PERF_DTLB_RMISS] = r_hpmcounter3();
+  v[PERF_DTLB_WMISS] = r_hpmcounter4();
+  v[PERF_ITLB_MISS] = r_hpmcounter5();
+}
+
+// perfin - 调度器切换到进程之前调用，记下计数器的起点
+//
+void
+perfin(struct cpu *c)
+{
+  perfread(c->perfstart);
+}
+
+// perfout - 进程切回调度器（或在 switchto 中直接切走）之后调用，把这段时间的计数记到 p 上
+//
+// 前提：持有 p->lock
+//
+void
+perfout(struct cpu *c, struct proc *p)
+{
+  uint64 now[NPERFCTR];
+
+  perfread(now);
+  for(int i = 0; i < NPERFCTR; i++)
+    p->perf[i] += now[i] - c->perfstart[i];
+}
+
+// perfreap - wait 回收子进程 child 时调用，把它的计数并入 p
+//
+// 前提：持有 child->lock，child 已经彻底切换出去
+//
+void
+perfreap(struct proc *p, struct proc *child)
+{
+  for(int i = 0; i < NPERFCTR; i++)
+    p->perfchild[i] += child->perf[i] + child->perfchild[i];
+}
+
+// perfstat - 把进程的计数复制到用户空间
+//
+// 参数：
+//   pid:  PERF_SELF 取当前进程（包括本次运行到现在的部分），
+//         PERF_CHILDREN 取当前进程已回收的子孙之和，
+//         其他值取该 pid 的进程（正在其他 CPU 上运行时，
+//         只包含到它上次切换出去为止的部分）
+//   addr: 用户空间的 struct perfstat
+//
+// 返回值：0，或 -ESRCH / -EFAULT
+//
+int
+perfstat(int pid, uint64 addr)
+{
+  struct perfstat st;
+  struct proc *p = myproc();
+  uint64 now[NPERFCTR];
+  int i;
+
+  if(pid == PERF_SELF){
+    // 关中断，读数期间不会被切换出去
+    push_off();
+    perfread(now);
+    for(i = 0; i < NPERFCTR; i++)
+      st.ctr[i] = p->perf[i] + now[i] - mycpu()->perfstart[i];
+    pop_off();
+  } else if(pid == PERF_CHILDREN){
+    for(i = 0; i < NPERFCTR; i++)
+      st.ctr[i] = p->perfchild[i];
+  } else {
+    struct proc *q = findproc(pid);
+    if(q == 0)
+      return -ESRCH;
+    for(i = 0; i < NPERFCTR; i++)
+      st.ctr[i] = q->perf[i];
+    release(&q->lock);
+  }
+
+  if(copyout(p->pagetable, addr, (char *)&st, sizeof(st)) < 0)
+    return -EFAULT;
+  return 0;
+}
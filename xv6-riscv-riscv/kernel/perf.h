@@ -0,0 +1,23 @@
+// 按进程虚拟化的硬件性能计数器，内核 perf.c 维护，用户态 perf_stat() 读出。
+//
+// 调度器在进程切换进来和切换出去时读硬件计数器，把差值累加到进程上，
+// 因此每个进程看到的是自己在 CPU 上（用户态和内核态）期间的计数，
+// 与其他进程无关。
+//
+// cycle、instret 总是可用；后三个是 hpmcounter3..5，
+// 在 qemu virt 上统计 TLB 缺失，其他平台上可能一直是 0。
+//
+// 需要先包含 param.h（NPERFCTR）。
+//
+#define PERF_CYCLES      0     // cycle
+#define PERF_INSTRET     1     // instret
+#define PERF_DTLB_RMISS  2     // hpmcounter3：数据 TLB 读缺失
+#define PERF_DTLB_WMISS  3     // hpmcounter4：数据 TLB 写缺失
+#define PERF_ITLB_MISS   4     // hpmcounter5：指令 TLB 缺失
+
+#define PERF_SELF        0     // perf_stat() 的 pid：当前进程
+#define PERF_CHILDREN    (-1)  // perf_stat() 的 pid：当前进程已回收的子孙进程之和
+
+struct perfstat {
+  uint64 ctr[NPERFCTR];        // 按 PERF_xxx 下标
+};
@@ -14,19 +14,47 @@
 #include "riscv.h"
 #include "defs.h"
 #include "proc.h"
+#include "klog.h"
 
 volatile int panicking = 0; // printing a panic message
 volatile int panicked = 0; // spinning forever at end of a panic
 
-// lock to avoid interleaving concurrent printf's.
-static struct {
-  struct spinlock lock;
-} pr;
+// printf() formats into a per-call buffer and commits it to
+// this CPU's log ring (klog.c) in KLOG_TEXT-sized records;
+// the UART driver sends the text out asynchronously.
+// a printf runs with interrupts off, so its records are
+// adjacent in one ring; they share the first record's
+// timestamp and all but the last carry KLOG_MORE, which
+// keeps the console from splicing other harts' text in.
+// no lock is shared between harts. while panicking, output
+// goes straight to the UART instead.
+struct pbuf {
+  int level;
+  uint64 ts;
+  int n;
+  char buf[KLOG_TEXT];
+};
 
 static char digits[] = "0123456789abcdef";
 
 static void
-printint(long long xx, int base, int sign)
+pputc(struct pbuf *pb, int c)
+{
+  if(panicking){
+    consputc(c);
+    return;
+  }
+  // commit a full buffer only once more text follows,
+  // so that the last record of a printf never has KLOG_MORE.
+  if(pb->n == KLOG_TEXT){
+    klog_commit(pb->level, pb->ts, KLOG_MORE, pb->buf, pb->n);
+    pb->n = 0;
+  }
+  pb->buf[pb->n++] = c;
+}
+
+static void
+printint(struct pbuf *pb, long long xx, int base, int sign)
 {
   char buf[20];
   int i;
@@ -46,34 +74,44 @@ printint(long long xx, int base, int sign)
     buf[i++] = '-';
 
   while(--i >= 0)
-    consputc(buf[i]);
+    pputc(pb, buf[i]);
 }
 
 static void
-printptr(uint64 x)
+printptr(struct pbuf *pb, uint64 x)
 {
   int i;
-  consputc('0');
-  consputc('x');
+  pputc(pb, '0');
+  pputc(pb, 'x');
   for (i = 0; i < (sizeof(uint64) * 2); i++, x <<= 4)
-    consputc(digits[x >> (sizeof(uint64) * 8 - 4)]);
+    pputc(pb, digits[x >> (sizeof(uint64) * 8 - 4)]);
 }
 
-// Print to the console.
-int
-printf(char *fmt, ...)
+static void
+vklog(int level, char *fmt, va_list ap)
 {
-  va_list ap;
+  struct pbuf pb;
   int i, cx, c0, c1, c2;
   char *s;
-
-  if(panicking == 0)
-    acquire(&pr.lock);
-
-  va_start(ap, fmt);
+  int kick;
+
+  // keep the whole call on one CPU (mycpu() is only stable
+  // with interrupts off) and its records adjacent.
+  push_off();
+
+  // sending the text takes the UART's tx_lock, which is only
+  // safe if this CPU holds no other locks (beyond push_off()
+  // above). otherwise the next UART or timer interrupt sends
+  // it, or klog_commit() drains the ring synchronously if it
+  // fills up first.
+  kick = mycpu()->noff == 1;
+
+  pb.level = level;
+  pb.ts = r_time();
+  pb.n = 0;
   for(i = 0; (cx = fmt[i] & 0xff) != 0; i++){
     if(cx != '%'){
-      consputc(cx);
+      pputc(&pb, cx);
       continue;
     }
     i++;
@@ -82,70 +120,90 @@ printf(char *fmt, ...)
     if(c0) c1 = fmt[i+1] & 0xff;
     if(c1) c2 = fmt[i+2] & 0xff;
     if(c0 == 'd'){
-      printint(va_arg(ap, int), 10, 1);
+      printint(&pb, va_arg(ap, int), 10, 1);
     } else if(c0 == 'l' && c1 == 'd'){
-      printint(va_arg(ap, uint64), 10, 1);
+      printint(&pb, va_arg(ap, uint64), 10, 1);
       i += 1;
     } else if(c0 == 'l' && c1 == 'l' && c2 == 'd'){
-      printint(va_arg(ap, uint64), 10, 1);
+      printint(&pb, va_arg(ap, uint64), 10, 1);
       i += 2;
     } else if(c0 == 'u'){
-      printint(va_arg(ap, uint32), 10, 0);
+      printint(&pb, va_arg(ap, uint32), 10, 0);
     } else if(c0 == 'l' && c1 == 'u'){
-      printint(va_arg(ap, uint64), 10, 0);
+      printint(&pb, va_arg(ap, uint64), 10, 0);
       i += 1;
     } else if(c0 == 'l' && c1 == 'l' && c2 == 'u'){
-      printint(va_arg(ap, uint64), 10, 0);
+      printint(&pb, va_arg(ap, uint64), 10, 0);
       i += 2;
     } else if(c0 == 'x'){
-      printint(va_arg(ap, uint32), 16, 0);
+      printint(&pb, va_arg(ap, uint32), 16, 0);
     } else if(c0 == 'l' && c1 == 'x'){
-      printint(va_arg(ap, uint64), 16, 0);
+      printint(&pb, va_arg(ap, uint64), 16, 0);
       i += 1;
     } else if(c0 == 'l' && c1 == 'l' && c2 == 'x'){
-      printint(va_arg(ap, uint64), 16, 0);
+      printint(&pb, va_arg(ap, uint64), 16, 0);
       i += 2;
     } else if(c0 == 'p'){
-      printptr(va_arg(ap, uint64));
+      printptr(&pb, va_arg(ap, uint64));
     } else if(c0 == 'c'){
-      consputc(va_arg(ap, uint));
+      pputc(&pb, va_arg(ap, uint));
     } else if(c0 == 's'){
       if((s = va_arg(ap, char*)) == 0)
         s = "(null)";
       for(; *s; s++)
-        consputc(*s);
+        pputc(&pb, *s);
     } else if(c0 == '%'){
-      consputc('%');
+      pputc(&pb, '%');
     } else if(c0 == 0){
       break;
     } else {
       // Print unknown % sequence to draw attention.
-      consputc('%');
-      consputc(c0);
+      pputc(&pb, '%');
+      pputc(&pb, c0);
     }
 
   }
-  va_end(ap);
+  if(pb.n > 0 && !panicking)
+    klog_commit(level, pb.ts, 0, pb.buf, pb.n);
+  pop_off();
+  if(kick && !panicking)
+    uartkick();
+}
+
+// Print to the console.
+int
+printf(char *fmt, ...)
+{
+  va_list ap;
 
-  if(panicking == 0)
-    release(&pr.lock);
+  va_start(ap, fmt);
+  vklog(KLOG_INFO, fmt, ap);
+  va_end(ap);
 
   return 0;
 }
 
+// Print to the console at the given KLOG_ level.
+void
+klog(int level, char *fmt, ...)
+{
+  va_list ap;
+
+  va_start(ap, fmt);
+  vklog(level, fmt, ap);
+  va_end(ap);
+}
+
 void
 panic(char *s)
 {
+  // push out what is already buffered, then print
+  // the panic message synchronously.
   panicking = 1;
+  uartpanicflush();
   printf("panic: ");
   printf("%s\n", s);
   panicked = 1; // freeze uart output from other CPUs
   for(;;)
     ;
 }
-
-void
-printfinit(void)
-{
-  initlock(&pr.lock, "pr");
-}
@@ -8,7 +8,10 @@
 // 4. 进程通信和资源管理
 //
 // 关键数据结构：
-// - proc[NPROC]: 进程表（固定大小数组，最多 64 个进程）
+// - allproc: 进程表（按需分配的 proc 结构体链表，最多 NPROC 个）
+// - pidhash: pid → proc 哈希表
+// - pghash: pgid → 进程组成员哈希表
+// - sleepq: 按睡眠通道哈希的睡眠队列
 // - cpus[NCPU]: CPU 核心状态数组
 //
 
@@ -19,6 +22,8 @@
 #include "spinlock.h"
 #include "proc.h"
 #include "defs.h"
+#include "errno.h"
+#include "tracepoint.h"
 
 
 // 全局变量
@@ -26,11 +31,52 @@
 
 struct cpu cpus[NCPU];          // 所有 CPU 核心的状态数组
 
-struct proc proc[NPROC];        // 进程表：固定大小数组
-                                // 使用数组而非链表的原因：
-                                // 1. 简单可靠，不需要动态内存分配
-                                // 2. 遍历效率高（缓存友好）
-                                // 3. 索引可以直接映射到内核栈地址
+struct proc *allproc;           // 进程表：所有创建过的 proc 结构体
+                                // proc 结构体从整页中按需切出，连同内核栈
+                                // 一起创建，之后从不释放，只在空闲链表和
+                                // 使用中之间转换，因此指针永远有效：
+                                // 可以不加锁遍历 allproc，
+                                // 也可以先查哈希表、再加锁复查
+
+static struct proc *procfree;   // 空闲的 proc 结构体（state == UNUSED）
+static char *procslab;          // 当前切分中的页
+static char *procslabend;
+static int nprocs;              // 已创建的 proc 结构体数，不超过 NPROC
+struct spinlock proctab_lock;   // 保护以上四项，以及内核页表中的内核栈映射
+
+uint64 kstackgen;               // 每映射一个新内核栈加 1（见 scheduler）
+
+static int nrunnable;           // state == RUNNABLE 的进程数（见 setstate），
+                                // 时钟 tick 据此判断是否有人在等 CPU
+
+#define NUCTX 32                // 缓存的 trapframe/页表对数（见 uctxalloc）
+static struct {
+  struct spinlock lock;
+  int n;
+  struct {
+    pagetable_t pagetable;
+    struct trapframe *trapframe;
+  } ent[NUCTX];
+} uctxcache;
+
+#define NPIDHASH 256
+#define PIDHASH(pid) ((pid) & (NPIDHASH - 1))
+static struct proc *pidhash[NPIDHASH];  // pid → proc，受 pid_lock 保护
+static struct proc *pghash[NPIDHASH];   // pgid → 组内进程，受 wait_lock 保护
+
+// 睡眠队列：sleep() 把进程挂到通道所哈希到的队列上，
+// wakeup() 只检查这一条队列，而不是遍历所有进程
+//
+// 锁顺序：条件锁 lk → sq->lock → p->lock
+//
+#define NSLEEPQ 64
+#define SLEEPQ(chan) \
+  (&sleepq[(((uint64)(chan) >> 3) ^ ((uint64)(chan) >> 11)) & (NSLEEPQ - 1)])
+struct sleepq {
+  struct spinlock lock;
+  struct proc *head;
+};
+static struct sleepq sleepq[NSLEEPQ];
 
 struct proc *initproc;          // 指向 init 进程的指针
                                 // init 是第一个用户进程，PID = 1
@@ -40,16 +86,35 @@ int nextpid = 1;                // 下一个要分配的 PID
                                 // 从 1 开始递增（PID 0 保留）
                                 // 受 pid_lock 保护
 
-struct spinlock pid_lock;       // 保护 nextpid 的自旋锁
+struct spinlock pid_lock;       // 保护 nextpid 和 pidhash 的自旋锁
                                 // 多个 CPU 可能同时 fork，需要原子分配 PID
 
 extern void forkret(void);      // fork 子进程第一次调度时的入口函数
 static void freeproc(struct proc *p);  // 释放进程资源的内部函数
+static void addchild(struct proc *parent, struct proc *p);
+static void pgjoin(struct proc *p, int pgid);
+static void pgleave(struct proc *p);
+static void finishswitch(void);
+
+// setstate - 修改 p->state，同时维护 nrunnable
+//
+// 进入或离开 RUNNABLE 的状态变化都必须经过这里；调用者持有 p->lock
+//
+static void
+setstate(struct proc *p, enum procstate state)
+{
+  if(p->state == RUNNABLE)
+    __atomic_sub_fetch(&nrunnable, 1, __ATOMIC_RELAXED);
+  if(state == RUNNABLE)
+    __atomic_add_fetch(&nrunnable, 1, __ATOMIC_RELAXED);
+  p->state = state;
+}
 
 extern char trampoline[];       // trampoline.S 中定义的跳板代码起始地址
+extern pagetable_t kernel_pagetable;
 
 // wait_lock 的作用：
-// 1. 保护进程的父子关系（p->parent）
+// 1. 保护进程的父子关系（p->parent 和子进程链表）以及进程组
 // 2. 确保 wait() 和 exit() 的唤醒不会丢失
 // 3. 遵循内存模型，避免重排序导致的问题
 // 
@@ -89,12 +154,13 @@ static struct proc* default_round_robin(void);
 struct proc* (*select_next_proc)(void) = default_round_robin;
 
 
-// proc_mapstacks - 为所有进程分配并映射内核栈
+// procnew - 创建一个新的 proc 结构体及其内核栈
 
 //
-// 调用时机：在 kvminit() 中调用，初始化内核页表时
+// 前提条件：持有 proctab_lock
 //
-// 内核栈布局（每个进程）：
+// proc 结构体从整页中依次切出；内核栈单独占一页，映射到
+// 内核页表的 KSTACK(idx)，上方留一个未映射的 guard page：
 //   高地址：[Guard Page - 无映射，用于检测栈溢出]
 //          [内核栈 - 1 页 (4KB)，可读写]
 //   低地址：[下一个进程的 Guard Page...]
@@ -104,24 +170,52 @@ struct proc* (*select_next_proc)(void) = default_round_robin;
 // - 避免进程间的内核栈冲突
 // - 支持多核并行处理系统调用
 //
-void
-proc_mapstacks(pagetable_t kpgtbl)
+// TLB：新映射只在本 CPU 上刷新；其他 CPU 在 scheduler 切换到
+// 进程前比较 kstackgen，落后时再刷新（RISC-V 允许缓存无效的 PTE）
+//
+// 返回值：新的 proc（UNUSED，不在空闲链表上），
+//         进程数已达 NPROC 或内存不足时返回 0
+//
+static struct proc*
+procnew(void)
 {
   struct proc *p;
-  
-  // 遍历所有进程槽位
-  for(p = proc; p < &proc[NPROC]; p++) {
-    char *pa = kalloc();          // 为内核栈分配一个物理页
-    if(pa == 0)
-      panic("kalloc");
-    
-    uint64 va = KSTACK((int) (p - proc));  // 计算此进程的内核栈虚拟地址
-                                            // KSTACK 宏会留出 guard page
-    
-    // 在内核页表中建立映射：虚拟地址 va → 物理地址 pa
-    // 权限：PTE_R | PTE_W（可读写，内核专用）
-    kvmmap(kpgtbl, va, (uint64)pa, PGSIZE, PTE_R | PTE_W);
+  char *stack;
+
+  if(nprocs >= NPROC)
+    return 0;
+  if(procslab + sizeof(struct proc) > procslabend){
+    if((procslab = kalloc()) == 0){
+      procslabend = 0;
+      return 0;
+    }
+    zero_page(procslab);
+    procslabend = procslab + PGSIZE;
   }
+
+  // 先准备内核栈，失败时不消耗 slab 中的位置
+  if((stack = kalloc()) == 0)
+    return 0;
+  if(mappages(kernel_pagetable, KSTACK(nprocs), PGSIZE,
+              (uint64)stack, PTE_R | PTE_W) < 0){
+    kfree(stack);
+    return 0;
+  }
+  sfence_vma();
+  kstackgen++;
+
+  p = (struct proc*)procslab;
+  procslab += sizeof(struct proc);
+  initlock(&p->lock, "proc");
+  p->state = UNUSED;
+  p->idx = nprocs++;
+  p->kstack = KSTACK(p->idx);
+
+  // 填好字段后再发布，无锁遍历 allproc 的读者看到的总是完整的结构
+  p->allnext = allproc;
+  __sync_synchronize();
+  allproc = p;
+  return p;
 }
 
 
@@ -130,26 +224,17 @@ proc_mapstacks(pagetable_t kpgtbl)
 //
 // 调用时机：系统启动时，在 main() 中调用一次
 //
-// 初始化内容：
-// 1. 初始化全局锁（pid_lock, wait_lock）
-// 2. 初始化每个进程的锁和状态
-// 3. 设置内核栈地址
+// 只初始化全局锁；proc 结构体和内核栈在 allocproc 中按需创建
 //
 void
 procinit(void)
 {
-  struct proc *p;
-  
   initlock(&pid_lock, "nextpid");      // 初始化 PID 分配锁
   initlock(&wait_lock, "wait_lock");   // 初始化 wait 锁
-  
-  // 初始化进程表中的每个槽位
-  for(p = proc; p < &proc[NPROC]; p++) {
-      initlock(&p->lock, "proc");      // 初始化进程锁
-      p->state = UNUSED;               // 标记为未使用
-      p->kstack = KSTACK((int) (p - proc));  // 计算内核栈虚拟地址
-                                             // 地址在 proc_mapstacks 中已映射
-  }
+  initlock(&proctab_lock, "proctab");  // 初始化进程表锁
+  initlock(&uctxcache.lock, "uctxcache");
+  for(int i = 0; i < NSLEEPQ; i++)
+    initlock(&sleepq[i].lock, "sleepq");
 }
 
 
@@ -216,10 +301,10 @@ myproc(void)
 }
 
 
-// allocpid - 分配一个新的进程 ID
+// allocpid - 为进程 p 分配一个新的进程 ID，并加入 pid 哈希表
 
 //
-// 线程安全：使用 pid_lock 保护 nextpid
+// 线程安全：使用 pid_lock 保护 nextpid 和 pidhash
 //
 // PID 分配策略：简单递增
 // - 优点：实现简单，分配快速
@@ -230,25 +315,84 @@ myproc(void)
 // - PID 命名空间（容器隔离）
 // - 防止 PID 回绕攻击
 //
-int
-allocpid()
+static void
+allocpid(struct proc *p)
 {
-  int pid;
-  
+  int h;
+
   acquire(&pid_lock);         // 获取锁，保证原子性
-  pid = nextpid;              // 读取下一个 PID
+  p->pid = nextpid;           // 读取下一个 PID
   nextpid = nextpid + 1;      // 递增
+  h = PIDHASH(p->pid);
+  p->pidnext = pidhash[h];    // 插入哈希链头部
+  pidhash[h] = p;
   release(&pid_lock);         // 释放锁
-  
-  return pid;
+}
+
+// freepid - 把进程 p 从 pid 哈希表中删除，并清零 p->pid
+//
+// 哈希链很短（进程数 / NPIDHASH），线性查找前驱即可
+//
+static void
+freepid(struct proc *p)
+{
+  struct proc **pp;
+
+  acquire(&pid_lock);
+  for(pp = &pidhash[PIDHASH(p->pid)]; *pp != 0; pp = &(*pp)->pidnext){
+    if(*pp == p){
+      *pp = p->pidnext;
+      break;
+    }
+  }
+  p->pid = 0;
+  p->pidnext = 0;
+  release(&pid_lock);
 }
 
 
-// allocproc - 在进程表中查找并分配一个空闲的进程槽
+// findproc - 按 PID 查找进程
 
 //
-// 查找策略：线性扫描进程表
-// - 时间复杂度：O(NPROC)
+// 返回值：找到时返回进程指针，并持有 p->lock；否则返回 0
+//
+// 锁顺序：
+// - 查哈希表时只持有 pid_lock，释放后再获取 p->lock，
+//   因为 freeproc 在持有 p->lock 时会获取 pid_lock
+// - 两把锁之间进程可能已被回收甚至重新分配，
+//   所以拿到 p->lock 后要复查 pid；proc 结构体从不释放，
+//   这时访问 p 总是安全的
+//
+struct proc*
+findproc(int pid)
+{
+  struct proc *p;
+
+  if(pid <= 0)
+    return 0;
+
+  acquire(&pid_lock);
+  for(p = pidhash[PIDHASH(pid)]; p != 0; p = p->pidnext)
+    if(p->pid == pid)
+      break;
+  release(&pid_lock);
+  if(p == 0)
+    return 0;
+
+  acquire(&p->lock);
+  if(p->pid != pid || p->state == UNUSED){
+    release(&p->lock);
+    return 0;                 // 已被回收
+  }
+  return p;
+}
+
+
+// allocproc - 从进程表中分配一个空闲的进程
+
+//
+// 查找策略：从空闲链表取一个，链表为空时用 procnew 新建
+// - 时间复杂度：O(1)
 //
 // 返回值：
 // - 成功：返回进程指针，并持有 p->lock
@@ -269,41 +413,40 @@ allocproc(void)
 {
   struct proc *p;
 
-  // 遍历进程表，查找第一个 UNUSED 槽位
-  for(p = proc; p < &proc[NPROC]; p++) {
-    acquire(&p->lock);        // 获取进程锁
-    if(p->state == UNUSED) {
-      goto found;             // 找到空闲槽位
-    } else {
-      release(&p->lock);      // 不是空闲的，释放锁继续查找
-    }
-  }
-  return 0;                   // 进程表已满
+  acquire(&proctab_lock);
+  if((p = procfree) != 0)
+    procfree = p->nextfree;   // 复用空闲的 proc
+  else
+    p = procnew();            // 创建新的 proc 和内核栈
+  release(&proctab_lock);
+  if(p == 0)
+    return 0;                 // 进程数达到 NPROC 或内存不足
 
-found:
-  // 找到空闲槽位，开始初始化
-  p->pid = allocpid();        // 分配唯一的 PID
+  // 刚回到空闲链表的 proc 可能还被 kwait 锁着，这里会等它释放
+  acquire(&p->lock);
+
+  // 开始初始化
+  allocpid(p);                // 分配唯一的 PID
   p->state = USED;            // 标记为"正在使用"（过渡状态）
   p->priority = 5;            // 设置默认优先级为 5（中等优先级，范围 0-9）
   p->errno = 0;               // 初始化 errno 为 0（无错误）
+  p->tracemask = 0;           // 默认不跟踪系统调用
+  p->fdlimit = NOFILE;        // 默认打开文件数上限
+  memset(p->faultcnt, 0, sizeof(p->faultcnt));        // 页错误统计从零开始
+  memset(p->faultcycles, 0, sizeof(p->faultcycles));
+  memset(p->perf, 0, sizeof(p->perf));                // 硬件计数从零开始
+  memset(p->perfchild, 0, sizeof(p->perfchild));
+  memset(&p->stats, 0, sizeof(p->stats));             // 调度统计从零开始
   
   // 初始化 MLFQ 调度器字段
   p->mlfq_level = 0;          // 新进程从最高优先级队列开始
   p->time_used = 0;           // 时间片使用清零
   p->time_quantum = 1;        // Level 0 的时间片 = 1 tick
 
-  // 分配 trapframe 页
+  // 取一对 trapframe 页和用户页表（优先从缓存中取）
   // trapframe 用于保存用户态寄存器（trap 时使用）
-  if((p->trapframe = (struct trapframe *)kalloc()) == 0){
-    freeproc(p);              // 分配失败，清理并返回
-    release(&p->lock);
-    return 0;
-  }
-
-  // 创建空的用户页表
-  // 此时只包含 trampoline 和 trapframe 映射，没有用户代码和数据
-  p->pagetable = proc_pagetable(p);
-  if(p->pagetable == 0){
+  // 页表此时只包含 trampoline 和 trapframe 映射，没有用户代码和数据
+  if(uctxalloc(&p->pagetable, &p->trapframe) < 0){
     freeproc(p);              // 分配失败，清理并返回
     release(&p->lock);
     return 0;
@@ -327,35 +470,41 @@ found:
 // 前提条件：必须持有 p->lock
 //
 // 释放的资源：
-// 1. trapframe 页
-// 2. 用户页表和所有用户内存页
-// 3. 清空所有进程字段
+// 1. 用户内存页（页表和 trapframe 清理后放回缓存，见 uctxfree）
+// 2. 从 pid 哈希表删除，清空所有进程字段
+// 4. 放回空闲链表
 //
-// 注意：不释放内核栈（它是在 proc_mapstacks 中统一分配的）
+// 注意：不释放内核栈，它随 proc 结构体一起留给下一个进程
+// 调用者仍持有 p->lock；allocproc 拿到它后会等锁释放
 //
 static void
 freeproc(struct proc *p)
 {
-  // 释放 trapframe 页
-  if(p->trapframe)
-    kfree((void*)p->trapframe);
-  p->trapframe = 0;
-  
-  // 释放用户页表和所有用户内存
+  // 释放所有用户内存，页表和 trapframe 留作缓存
   // COW fork: 使用引用计数，可能不会立即释放共享页
   if(p->pagetable)
-    proc_freepagetable(p->pagetable, p->sz);
+    uctxfree(p->pagetable, p->trapframe, p->sz);
   p->pagetable = 0;
+  p->trapframe = 0;
   
   // 清空所有进程字段，恢复初始状态
+  freepid(p);                 // 同时清零 p->pid
   p->sz = 0;
-  p->pid = 0;
   p->parent = 0;
   p->name[0] = 0;
   p->chan = 0;
   p->killed = 0;
   p->xstate = 0;
   p->state = UNUSED;          // 标记为未使用，可以被重新分配
+
+  // 切换过调度策略时可能还留在 MLFQ 队列里，回收前摘下
+  if(p->mlfq_onq)
+    mlfq_remove_process(p, p->mlfq_onq - 1);
+
+  acquire(&proctab_lock);
+  p->nextfree = procfree;
+  procfree = p;
+  release(&proctab_lock);
 }
 
 
@@ -375,7 +524,7 @@ freeproc(struct proc *p)
 //   0            [起始地址]
 //
 pagetable_t
-proc_pagetable(struct proc *p)
+proc_pagetable(struct trapframe *tf)
 {
   pagetable_t pagetable;
 
@@ -401,7 +550,7 @@ proc_pagetable(struct proc *p)
 
   // 映射 trapframe 页（紧邻 trampoline 下方）
   // 虚拟地址：TRAPFRAME
-  // 物理地址：p->trapframe（每个进程独立的物理页）
+  // 物理地址：tf（每个进程独立的物理页）
   // 权限：PTE_R | PTE_W（可读写，但无 PTE_U，用户不可访问）
   //
   // 为什么需要映射到用户页表？
@@ -409,7 +558,7 @@ proc_pagetable(struct proc *p)
   // - 使用固定虚拟地址 TRAPFRAME，所有进程相同
   // - 但映射到不同的物理页，实现隔离
   if(mappages(pagetable, TRAPFRAME, PGSIZE,
-              (uint64)(p->trapframe), PTE_R | PTE_W) < 0){
+              (uint64)tf, PTE_R | PTE_W) < 0){
     uvmunmap(pagetable, TRAMPOLINE, 1, 0);
     uvmfree(pagetable, 0);
     return 0;
@@ -440,6 +589,91 @@ proc_freepagetable(pagetable_t pagetable, uint64 sz)
 }
 
 
+// 用户上下文缓存
+
+//
+// 每个进程都需要一个 trapframe 页和一个映射了 trampoline、
+// trapframe 的根页表。不缓存的话，每次 fork/exec 都要分配根页表
+// 和通往 TRAMPOLINE 的两级页表页并建映射，回收时再全部拆掉。
+//
+// 因此成对缓存：进程回收时只释放用户内存和其余页表页，
+// 根页表连同 trampoline/trapframe 映射保留下来，下一次
+// allocproc 或 exec 直接取用。缓存满了才真正释放。
+//
+// 内核栈不需要单独缓存：它随 proc 结构体一起复用（见 procnew）
+//
+
+
+// uctxalloc - 取一对 trapframe 和用户页表
+//
+// 返回值：0 成功，-1 内存不足
+//
+int
+uctxalloc(pagetable_t *pagetable, struct trapframe **tf)
+{
+  acquire(&uctxcache.lock);
+  if(uctxcache.n > 0){
+    uctxcache.n--;
+    *pagetable = uctxcache.ent[uctxcache.n].pagetable;
+    *tf = uctxcache.ent[uctxcache.n].trapframe;
+    release(&uctxcache.lock);
+    return 0;
+  }
+  release(&uctxcache.lock);
+
+  if((*tf = (struct trapframe *)kalloc()) == 0)
+    return -1;
+  if((*pagetable = proc_pagetable(*tf)) == 0){
+    kfree((void*)*tf);
+    return -1;
+  }
+  return 0;
+}
+
+// uctxfree - 释放大小为 sz 的用户内存，把页表和 trapframe 放回缓存
+//
+// uvmreset 之后页表只剩 trampoline 和 trapframe 映射，
+// 与 proc_pagetable 刚建好时一样
+//
+void
+uctxfree(pagetable_t pagetable, struct trapframe *tf, uint64 sz)
+{
+  uvmreset(pagetable, sz);
+
+  acquire(&uctxcache.lock);
+  if(uctxcache.n < NUCTX){
+    uctxcache.ent[uctxcache.n].pagetable = pagetable;
+    uctxcache.ent[uctxcache.n].trapframe = tf;
+    uctxcache.n++;
+    release(&uctxcache.lock);
+    return;
+  }
+  release(&uctxcache.lock);
+
+  proc_freepagetable(pagetable, 0);
+  kfree((void*)tf);
+}
+
+// uctxswap - 交换两个用户页表的 TRAPFRAME 映射
+//
+// exec 用它把进程正在用的 trapframe 移到新页表上，
+// p->trapframe 指针保持不变，缓存中取来的那一页随旧页表释放
+//
+void
+uctxswap(pagetable_t a, pagetable_t b)
+{
+  pte_t *pa = walk(a, TRAPFRAME, 0);
+  pte_t *pb = walk(b, TRAPFRAME, 0);
+  pte_t t;
+
+  if(pa == 0 || pb == 0)
+    panic("uctxswap");
+  t = *pa;
+  *pa = *pb;
+  *pb = t;
+}
+
+
 // userinit - 创建并初始化第一个用户进程
 
 //
@@ -467,9 +701,15 @@ userinit(void)
   
   p->cwd = namei("/");        // 设置当前目录为根目录
 
-  p->state = RUNNABLE;        // 标记为可运行，等待调度
+  setstate(p, RUNNABLE);      // 标记为可运行，等待调度
 
   release(&p->lock);          // 释放锁
+
+  // init 自成一个会话和进程组，之后的进程都继承它
+  acquire(&wait_lock);
+  p->sid = p->pid;
+  pgjoin(p, p->pid);
+  release(&wait_lock);
 }
 
 
@@ -551,7 +791,7 @@ growproc(int n)
 int
 kfork(void)
 {
-  int i, pid;
+  int pid;
   struct proc *np;            // 新进程指针（子进程）
   struct proc *p = myproc();  // 当前进程指针（父进程）
 
@@ -585,9 +825,12 @@ kfork(void)
   // 复制打开的文件描述符
   // 父子进程共享打开的文件，增加引用计数
   // 这样父子进程可以独立关闭文件
-  for(i = 0; i < NOFILE; i++)
-    if(p->ofile[i])
-      np->ofile[i] = filedup(p->ofile[i]);  // 增加文件引用计数
+  // 同时继承打开文件数上限
+  if(fdcopy(np, p) < 0){
+    freeproc(np);             // fd 表页分配失败，清理子进程
+    release(&np->lock);
+    return -1;
+  }
   
   // 复制当前工作目录
   np->cwd = idup(p->cwd);     // 增加 inode 引用计数
@@ -595,6 +838,9 @@ kfork(void)
   // 复制进程名称（用于调试）
   safestrcpy(np->name, p->name, sizeof(p->name));
 
+  // 继承系统调用跟踪掩码（strace 跟踪整个进程树）
+  np->tracemask = p->tracemask;
+
   pid = np->pid;              // 保存子进程 PID（用于返回）
 
   release(&np->lock);         // 释放子进程锁
@@ -603,11 +849,14 @@ kfork(void)
   // 使用 wait_lock 保护（避免与 wait/exit 竞争）
   acquire(&wait_lock);
   np->parent = p;             // 设置父进程指针
+  addchild(p, np);            // 加入父进程的子进程链表
+  np->sid = p->sid;           // 继承会话和进程组
+  pgjoin(np, p->pgid);
   release(&wait_lock);
 
   // 将子进程标记为可运行
   acquire(&np->lock);
-  np->state = RUNNABLE;       // 现在可以被调度器选中了
+  setstate(np, RUNNABLE);     // 现在可以被调度器选中了
   int child_priority = np->priority;  // 保存子进程优先级（避免重复加锁）
   int child_level = np->mlfq_level;   // 保存 MLFQ 级别
   release(&np->lock);
@@ -630,6 +879,84 @@ kfork(void)
 }
 
 
+// addchild / delchild - 维护子进程链表
+
+//
+// 前提条件：调用者必须持有 wait_lock
+//
+// children 是双向链表，子进程退出时 O(1) 删除；
+// zombies 只从头部取出或整体移交，用 nextsib 单向链接即可
+//
+static void
+addchild(struct proc *parent, struct proc *p)
+{
+  p->prevsib = 0;
+  p->nextsib = parent->children;
+  if(parent->children)
+    parent->children->prevsib = p;
+  parent->children = p;
+}
+
+static void
+delchild(struct proc *p)
+{
+  if(p->prevsib)
+    p->prevsib->nextsib = p->nextsib;
+  else
+    p->parent->children = p->nextsib;
+  if(p->nextsib)
+    p->nextsib->prevsib = p->prevsib;
+  p->nextsib = p->prevsib = 0;
+}
+
+
+// pgjoin / pgleave / pgfind - 维护进程组哈希表
+
+//
+// 前提条件：调用者必须持有 wait_lock
+//
+// 同一组的成员都在 pghash[PIDHASH(pgid)] 这条链上，
+// 给整组发信号只需遍历这一条链，代价与进程总数无关
+//
+static void
+pgjoin(struct proc *p, int pgid)
+{
+  int h = PIDHASH(pgid);
+
+  p->pgid = pgid;
+  p->pgprev = 0;
+  p->pgnext = pghash[h];
+  if(pghash[h])
+    pghash[h]->pgprev = p;
+  pghash[h] = p;
+}
+
+static void
+pgleave(struct proc *p)
+{
+  if(p->pgprev)
+    p->pgprev->pgnext = p->pgnext;
+  else
+    pghash[PIDHASH(p->pgid)] = p->pgnext;
+  if(p->pgnext)
+    p->pgnext->pgprev = p->pgprev;
+  p->pgnext = p->pgprev = 0;
+  p->pgid = 0;
+}
+
+// 返回进程组 pgid 中的任意一个成员，组不存在时返回 0
+static struct proc*
+pgfind(int pgid)
+{
+  struct proc *p;
+
+  for(p = pghash[PIDHASH(pgid)]; p != 0; p = p->pgnext)
+    if(p->pgid == pgid)
+      return p;
+  return 0;
+}
+
+
 // reparent - 将进程的所有子进程过继给 init 进程
 
 //
@@ -643,22 +970,38 @@ kfork(void)
 // - init 进程会周期性调用 wait 回收僵尸子进程
 //
 // 流程：
-// 1. 遍历进程表
-// 2. 找到所有 parent == p 的进程
-// 3. 将它们的 parent 改为 initproc
-// 4. 如果有僵尸进程，唤醒 init 去回收
+// 1. 遍历 p 的两条子进程链表，将 parent 改为 initproc
+// 2. 把两条链表分别接到 init 对应链表的头部
+// 3. 有僵尸进程时唤醒 init 去回收
+//
+// 时间复杂度：O(p 的子进程数)，与进程总数无关
 //
 void
 reparent(struct proc *p)
 {
-  struct proc *pp;
+  struct proc *pp, *last;
 
-  // 遍历所有进程，查找子进程
-  for(pp = proc; pp < &proc[NPROC]; pp++){
-    if(pp->parent == p){
+  if(p->children){
+    for(pp = p->children; pp != 0; pp = pp->nextsib){
       pp->parent = initproc;  // 过继给 init 进程
-      wakeup(initproc);       // 唤醒 init（如果它在 wait 中睡眠）
+      last = pp;
+    }
+    last->nextsib = initproc->children;
+    if(initproc->children)
+      initproc->children->prevsib = last;
+    initproc->children = p->children;
+    p->children = 0;
+  }
+
+  if(p->zombies){
+    for(pp = p->zombies; pp != 0; pp = pp->nextsib){
+      pp->parent = initproc;
+      last = pp;
     }
+    last->nextsib = initproc->zombies;
+    initproc->zombies = p->zombies;
+    p->zombies = 0;
+    wakeup(initproc);         // 唤醒 init（如果它在 wait 中睡眠）
   }
 }
 
@@ -697,13 +1040,7 @@ kexit(int status)
 
   // 关闭所有打开的文件
   // 减少文件引用计数，可能触发文件关闭
-  for(int fd = 0; fd < NOFILE; fd++){
-    if(p->ofile[fd]){
-      struct file *f = p->ofile[fd];
-      fileclose(f);           // 关闭文件，减少引用计数
-      p->ofile[fd] = 0;       // 清空文件描述符槽位
-    }
-  }
+  fdcloseall(p);              // 同时释放 fd 表页
 
   // 释放当前工作目录的 inode
   // begin_op/end_op 确保文件系统操作的原子性
@@ -717,6 +1054,14 @@ kexit(int status)
   // 将所有子进程过继给 init 进程
   reparent(p);
 
+  // 离开进程组，之后的 killpg 不会再找到它
+  pgleave(p);
+
+  // 从父进程的 children 移到 zombies，父进程的 wait() 直接取用
+  delchild(p);
+  p->nextsib = p->parent->zombies;
+  p->parent->zombies = p;
+
   // 唤醒父进程（如果父进程在 wait() 中睡眠）
   wakeup(p->parent);
   
@@ -759,8 +1104,8 @@ kexit(int status)
 // - 失败：返回 -1（没有子进程或被杀死）
 //
 // 等待逻辑：
-// 1. 扫描进程表查找僵尸子进程
-// 2. 如果找到，回收并返回
+// 1. 子进程退出时已把自己放到 p->zombies 上，直接取头部
+// 2. 如果有，回收并返回（O(1)，与子进程数无关）
 // 3. 如果没有僵尸子进程但有活着的子进程，睡眠等待
 // 4. 如果没有子进程，返回 -1
 //
@@ -772,47 +1117,40 @@ int
 kwait(uint64 addr)
 {
   struct proc *pp;
-  int havekids, pid;
+  int pid;
   struct proc *p = myproc();
 
   acquire(&wait_lock);        // 获取 wait 锁（保护父子关系）
 
   for(;;){
-    // 扫描进程表，查找已退出的子进程
-    havekids = 0;             // 是否有子进程（活着的或僵尸的）
-    
-    for(pp = proc; pp < &proc[NPROC]; pp++){
-      if(pp->parent == p){    // 找到子进程
-        // 确保子进程不在 exit() 或 swtch() 中
-        acquire(&pp->lock);
-
-        havekids = 1;         // 标记"有子进程"
-        
-        if(pp->state == ZOMBIE){
-          // 找到一个僵尸子进程！
-          pid = pp->pid;      // 保存 PID（用于返回）
-          
-          // 如果 addr 非零，将退出状态复制到用户空间
-          if(addr != 0 && copyout(p->pagetable, addr, (char *)&pp->xstate,
-                                  sizeof(pp->xstate)) < 0) {
-            release(&pp->lock);
-            release(&wait_lock);
-            return -1;        // copyout 失败
-          }
+    if((pp = p->zombies) != 0){
+      // 有僵尸子进程，取链表头部
+      // 获取 pp->lock 等它在 sched() 中彻底切换出去
+      acquire(&pp->lock);
+      pid = pp->pid;          // 保存 PID（用于返回）
           
-          // 释放子进程的所有资源
-          freeproc(pp);       // 释放内存、页表等
-          release(&pp->lock);
-          release(&wait_lock);
-          return pid;         // 返回子进程 PID
-        }
-        
+      // 如果 addr 非零，将退出状态复制到用户空间
+      // 失败时僵尸进程留在链表上，下次 wait 还能回收
+      if(addr != 0 && copyout(p->pagetable, addr, (char *)&pp->xstate,
+                              sizeof(pp->xstate)) < 0) {
         release(&pp->lock);
+        release(&wait_lock);
+        return -1;            // copyout 失败
       }
+          
+      perfreap(p, pp);        // 子进程的硬件计数并入 p->perfchild
+
+      // 释放子进程的所有资源
+      p->zombies = pp->nextsib;   // 从僵尸链表删除
+      pp->nextsib = 0;
+      freeproc(pp);           // 释放内存、页表等
+      release(&pp->lock);
+      release(&wait_lock);
+      return pid;             // 返回子进程 PID
     }
 
-    // 没有找到僵尸子进程
-    if(!havekids || killed(p)){
+    // 没有僵尸子进程
+    if(p->children == 0 || killed(p)){
       // 情况1：根本没有子进程
       // 情况2：当前进程被杀死
       release(&wait_lock);
@@ -820,7 +1158,7 @@ kwait(uint64 addr)
     }
     
     // 有子进程，但都还活着，睡眠等待
-    // 当子进程 exit 时会 wakeup(p->parent)
+    // 当子进程 exit 时会把自己放到 p->zombies 并 wakeup(p)
     sleep(p, &wait_lock);     // 在 wait_lock 上睡眠
                               // sleep 会释放 wait_lock，唤醒后重新获取
   }
@@ -888,18 +1226,31 @@ scheduler(void)
         // 1. 在返回调度器前释放 p->lock
         // 2. 在返回调度器前重新获取 p->lock
         // 这确保调度器可以安全地在循环中释放锁
-        p->state = RUNNING;   // 标记为运行状态
+        setstate(p, RUNNING); // 标记为运行状态
         c->proc = p;          // 设置当前 CPU 运行的进程
+
+        // 其他 CPU 映射过新的内核栈，先刷新 TLB 再切换到 p 的栈上
+        if(c->kstackgen != kstackgen){
+          c->kstackgen = kstackgen;
+          sfence_vma();
+        }
         
         // 上下文切换：从调度器切换到进程
         // 保存：c->context（调度器的 ra, sp, s0-s11）
         // 恢复：p->context（进程的 ra, sp, s0-s11）
         // 然后跳转到 p->context.ra（通常是 forkret 或 sched 的返回点）
+        c->nswitch++;
+        TP(TP_SCHED_IN, 0, 0);
+        perfin(c);
         swtch(&c->context, &p->context);
 
         // 当进程再次 swtch 回来时，从这里继续执行
         // 此时进程已经运行了一段时间（可能 yield/sleep/exit）
         // 进程应该已经改变了 p->state（不再是 RUNNING）
+        // p 可能在 yield 时直接切换给了别的进程（见 switchto），
+        // 切回调度器的是 c->proc，持有的也是它的锁
+        p = c->proc;
+        perfout(c, p);          // 把这段运行期间的硬件计数记到 p 上
         c->proc = 0;          // 清空当前进程指针
       }
       
@@ -916,7 +1267,7 @@ scheduler(void)
 // default_round_robin - 默认的轮转调度策略
 //
 // 算法：简单轮转 (Round-Robin)
-// - 按照进程表顺序遍历
+// - 按照 allproc 链表顺序遍历
 // - 返回第一个 RUNNABLE 进程
 // - 公平性：所有进程机会均等
 // - 时间复杂度：O(n)
@@ -937,7 +1288,7 @@ default_round_robin(void)
   struct proc *p;
   
   // 线性遍历进程表
-  for(p = proc; p < &proc[NPROC]; p++) {
+  for(p = allproc; p != 0; p = p->allnext) {
     acquire(&p->lock);        // 临时获取锁检查状态
     
     if(p->state == RUNNABLE) {
@@ -1042,6 +1393,7 @@ sched(void)
 
   // 保存当前的 intena（进程的中断状态）
   intena = mycpu()->intena;
+  TP(TP_SCHED_OUT, p->state, 0);
   
   // 上下文切换：从进程切换回调度器
   // 保存：p->context（进程的内核执行状态）
@@ -1050,7 +1402,75 @@ sched(void)
   swtch(&p->context, &mycpu()->context);
   
   // 当进程再次被调度时，从这里继续执行
+  // 可能是另一个进程直接切换过来的，先释放它的锁
   // 恢复进程的 intena
+  finishswitch();
+  mycpu()->intena = intena;
+}
+
+
+// finishswitch - 进程恢复运行后调用
+//
+// 如果是另一个进程在 yield 中直接切换过来的（switchto），
+// 它的锁一直持有到现在：切换前放开的话，其他 CPU 可能在
+// 还没离开它的内核栈时就运行它。现在已经在本进程的栈上，可以释放
+//
+static void
+finishswitch(void)
+{
+  struct cpu *c = mycpu();
+  struct proc *prev = c->handoff;
+
+  if(prev){
+    c->handoff = 0;
+    release(&prev->lock);
+  }
+}
+
+
+// switchto - 从当前进程 p 直接切换到 np，不经过调度器线程
+//
+// 前提：
+// - 持有 p->lock 和 np->lock，且只持有这两个锁
+// - p->state 已经不是 RUNNING，np->state == RUNNABLE
+//
+// 相比 sched() 切到调度器再由调度器切到 np，省掉一次 swtch
+// 和一轮调度循环。调度器在 swtch 之后、运行进程之前做的事
+// （状态、c->proc、TLB 刷新、统计）在这里做；p->lock 由 np
+// 恢复运行后在 finishswitch 中释放，np->lock 由 np 自己释放
+//
+static void
+switchto(struct proc *p, struct proc *np)
+{
+  struct cpu *c = mycpu();
+  int intena;
+
+  if(c->noff != 2)
+    panic("switchto locks");
+  if(np->state != RUNNABLE)
+    panic("switchto");
+
+  intena = c->intena;
+  TP(TP_SCHED_OUT, p->state, 0);
+  perfout(c, p);
+
+  setstate(np, RUNNING);
+  c->proc = np;
+  c->handoff = p;
+
+  // 其他 CPU 映射过新的内核栈，先刷新 TLB 再切换到 np 的栈上
+  if(c->kstackgen != kstackgen){
+    c->kstackgen = kstackgen;
+    sfence_vma();
+  }
+
+  c->nswitch++;
+  TP(TP_SCHED_IN, 0, 0);
+  perfin(c);
+  swtch(&p->context, &np->context);
+
+  // 和 sched() 一样，回到 p 时可能是别的进程直接切换过来的
+  finishswitch();
   mycpu()->intena = intena;
 }
 
@@ -1066,9 +1486,10 @@ sched(void)
 // 实现：
 // 1. 获取进程锁
 // 2. 改变状态为 RUNNABLE（重新进入就绪队列）
-// 3. 调用 sched() 切换到调度器
+// 3. 调用 sched() 切换到调度器；轮转调度下有其他就绪进程时
+//    改用 switchto() 直接切换过去
 // 4. 调度器选择其他进程（或重新选择此进程）
-// 5. 当再次被调度时，从 sched() 返回
+// 5. 当再次被调度时，从 sched()/switchto() 返回
 // 6. 释放进程锁，继续执行
 //
 // 为什么先 acquire 再 sched？
@@ -1080,7 +1501,35 @@ void
 yield(void)
 {
   struct proc *p = myproc();
-  acquire(&p->lock);          // 获取进程锁
+  struct proc *np = 0;
+
+  // 轮转调度下直接切换到下一个就绪进程，不经过调度器。
+  // 策略函数会临时获取各进程的锁，只能在 p 还是 RUNNING、
+  // 不持有 p->lock 时调用，所以 p 不是候选：轮转调度本来就该
+  // 让给别人，优先级和 MLFQ 则可能本该继续运行 p，这两种策略
+  // 仍由调度器在 p 重新入队后选择。
+  // 选择结果可能已经过时，np 甚至可能正在另一个 CPU 上 yield
+  // 并想锁 p，所以两把锁按地址顺序获取（其他地方不会同时
+  // 持有两个进程的锁）
+  if(select_next_proc == default_round_robin)
+    np = select_next_proc();
+  if(np == p)
+    np = 0;
+  if(np){
+    if(np < p){
+      acquire(&np->lock);
+      acquire(&p->lock);
+    } else {
+      acquire(&p->lock);
+      acquire(&np->lock);
+    }
+    if(np->state != RUNNABLE){  // 已被其他 CPU 选走
+      release(&np->lock);
+      np = 0;
+    }
+  } else {
+    acquire(&p->lock);        // 获取进程锁
+  }
   
   // MLFQ 调度器：从当前队列移除（因为要重新调度）
   extern struct proc* (*select_next_proc)(void);
@@ -1089,18 +1538,72 @@ yield(void)
     mlfq_remove_process(p, p->mlfq_level);
   }
   
-  p->state = RUNNABLE;        // 改变状态为可运行
+  setstate(p, RUNNABLE);    // 改变状态为可运行
   
   // MLFQ 调度器：重新加入队列（保持同一级别）
   if(select_next_proc == mlfq_scheduler) {
     mlfq_add_process(p, p->mlfq_level);
   }
   
-  sched();                    // 切换到调度器
+  if(np)
+    switchto(p, np);          // 直接切换到 np
+  else
+    sched();                  // 切换到调度器
   release(&p->lock);          // 切换回来后释放锁
 }
 
 
+// schedtick - 时钟 tick 时由 usertrap/kerneltrap 调用，决定是否抢占当前进程
+//
+// 记录当前进程用掉的时间片：MLFQ 下用完 time_quantum 时降级，
+// 其他策略下每 QUANTUM 个 tick 为一个时间片
+//
+// 返回值：1 表示应该 yield，即时间片用完且有其他进程在等 CPU；
+// 否则继续运行，省掉一次进出调度器的切换
+//
+int
+schedtick(void)
+{
+  struct proc *p = myproc();
+  int expired = 0;
+
+  acquire(&p->lock);
+  p->time_used++;
+  if(select_next_proc == mlfq_scheduler){
+    // 检查是否用完时间片
+    if(p->time_used >= p->time_quantum) {
+      expired = 1;
+      // 用完时间片，需要降级
+      if(p->mlfq_level < 4) {  // MAX_PRIORITY_LEVELS - 1
+        // 从当前队列移除
+        mlfq_remove_process(p, p->mlfq_level);
+
+        // 降级到下一级
+        p->mlfq_level++;
+        p->time_quantum = 1 << p->mlfq_level;  // 新的时间片
+        p->time_used = 0;                       // 重置计数
+
+        // 如果进程仍是 RUNNABLE，加入新队列
+        if(p->state == RUNNABLE) {
+          mlfq_add_process(p, p->mlfq_level);
+        }
+      } else {
+        // 已经在最低级，重置时间片
+        p->time_used = 0;
+      }
+    }
+  } else if(p->time_used >= QUANTUM){
+    expired = 1;
+    p->time_used = 0;
+  }
+  release(&p->lock);
+
+  // p 是 RUNNING，不在 nrunnable 中；不加锁读到的值可能已经过时，
+  // 只用作是否值得抢占的提示
+  return expired && __atomic_load_n(&nrunnable, __ATOMIC_RELAXED) > 0;
+}
+
+
 // forkret - fork 的子进程第一次被调度时的入口点
 
 //
@@ -1133,8 +1636,9 @@ forkret(void)
   static int first = 1;       // 静态变量，只有第一个进程为 1
   struct proc *p = myproc();
 
-  // 此时仍持有 p->lock（从 scheduler 继承）
-  // 必须释放，否则死锁
+  // 此时仍持有 p->lock（从 scheduler 或 switchto 继承）
+  // 必须释放，否则死锁；直接切换过来时还要释放上一个进程的锁
+  finishswitch();
   release(&p->lock);
 
   if (first) {
@@ -1174,6 +1678,38 @@ forkret(void)
 }
 
 
+// sqinsert / sqremove - 维护睡眠队列
+
+//
+// 前提条件：调用者必须持有 sq->lock
+//
+// 双向链表，唤醒和被杀死时都是 O(1) 删除
+//
+static void
+sqinsert(struct sleepq *sq, struct proc *p)
+{
+  p->sq = sq;
+  p->sqprev = 0;
+  p->sqnext = sq->head;
+  if(sq->head)
+    sq->head->sqprev = p;
+  sq->head = p;
+}
+
+static void
+sqremove(struct proc *p)
+{
+  if(p->sqprev)
+    p->sqprev->sqnext = p->sqnext;
+  else
+    p->sq->head = p->sqnext;
+  if(p->sqnext)
+    p->sqnext->sqprev = p->sqprev;
+  p->sq = 0;
+  p->sqnext = p->sqprev = 0;
+}
+
+
 // sleep - 在条件变量上睡眠
 
 //
@@ -1208,10 +1744,16 @@ forkret(void)
 // 6. 清空 chan，释放 p->lock，重新获取 lk
 // 7. 返回调用者，重新检查条件
 //
+// 睡眠队列：
+// - 第 4 步同时把进程挂到 chan 对应的 sleepq 上
+// - wakeup 唤醒时把进程摘下；被 kkill/kkillpg 直接改成
+//   RUNNABLE 的进程还在队列上，醒来后在第 6 步自己摘下
+//
 void
 sleep(void *chan, struct spinlock *lk)
 {
   struct proc *p = myproc();
+  struct sleepq *sq = SLEEPQ(chan);
   
   // 为什么必须先获取 p->lock？
   // - 改变 p->state 需要持有 p->lock
@@ -1222,6 +1764,7 @@ sleep(void *chan, struct spinlock *lk)
   // - wakeup 必须获取 p->lock 才能改变状态
   // - 所以在持有 p->lock 后释放 lk 是安全的
   
+  acquire(&sq->lock);         // 先拿睡眠队列锁，wakeup 也是这个顺序
   acquire(&p->lock);          // 获取进程锁 (DOC: sleeplock1)
   release(lk);                // 释放条件锁
 
@@ -1235,6 +1778,8 @@ sleep(void *chan, struct spinlock *lk)
   // 进入睡眠状态
   p->chan = chan;             // 记录睡眠通道（wakeup 用此识别）
   p->state = SLEEPING;        // 改变状态为睡眠
+  sqinsert(sq, p);            // 挂到睡眠队列上
+  release(&sq->lock);         // 持有 p->lock，wakeup 要等 sched 切走后才能唤醒
 
   sched();                    // 切换到调度器（让出 CPU）
 
@@ -1254,9 +1799,18 @@ sleep(void *chan, struct spinlock *lk)
     mlfq_add_process(p, p->mlfq_level);
   }
 
+  release(&p->lock);          // 释放进程锁
+
+  // 被 kkill 直接唤醒时还在睡眠队列上，自己摘下
+  // 进程已不是 SLEEPING，wakeup 不会再动它的 p->sq，不加锁读是安全的
+  if(p->sq){
+    acquire(&sq->lock);
+    sqremove(p);
+    release(&sq->lock);
+  }
+
   // 重新获取原来的锁
   // 这样调用者可以安全地重新检查条件
-  release(&p->lock);          // 释放进程锁
   acquire(lk);                // 重新获取条件锁
 }
 
@@ -1272,7 +1826,7 @@ sleep(void *chan, struct spinlock *lk)
 // - 确保在 wakeup 和进程睡眠之间不会有竞争
 //
 // 实现：
-// - 遍历所有进程
+// - 遍历 chan 所在的睡眠队列（见 sleepq），而不是所有进程
 // - 找到 SLEEPING 且 chan 匹配的进程
 // - 改变状态为 RUNNABLE（重新进入就绪队列）
 //
@@ -1288,21 +1842,27 @@ sleep(void *chan, struct spinlock *lk)
 void
 wakeup(void *chan)
 {
-  struct proc *p;
+  struct sleepq *sq = SLEEPQ(chan);
+  struct proc *p, *next;
 
-  // 遍历所有进程
-  for(p = proc; p < &proc[NPROC]; p++) {
+  // 只遍历 chan 所在的睡眠队列
+  acquire(&sq->lock);
+  for(p = sq->head; p != 0; p = next) {
+    next = p->sqnext;
     if(p != myproc()){        // 跳过当前进程
       acquire(&p->lock);      // 获取进程锁
       
-      // 检查是否匹配睡眠通道
+      // 队列中可能有哈希到同一位置的其他通道，检查是否匹配
       if(p->state == SLEEPING && p->chan == chan) {
-        p->state = RUNNABLE;  // 唤醒：改为可运行状态
+        setstate(p, RUNNABLE);  // 唤醒：改为可运行状态
+        sqremove(p);          // 离开睡眠队列
+        TP(TP_WAKEUP, p->pid, chan);
       }
       
       release(&p->lock);      // 释放进程锁
     }
   }
+  release(&sq->lock);
 }
 
 
@@ -1322,40 +1882,187 @@ wakeup(void *chan)
 // - 避免内核状态不一致
 //
 // 特殊处理：
-// - 如果进程在 SLEEPING，唤醒它
+// - 如果进程在 SLEEPING，立即唤醒它，不必等它的通道被 wakeup
 // - 这样它可以更快地检查 killed 标志并退出
+// - 它醒来后在 sleep() 中自己离开睡眠队列
 //
 // 查找方式：
-// - 线性扫描进程表，O(NPROC)
-// - 优化建议：使用哈希表可降到 O(1)
+// - 通过 pid 哈希表（findproc），O(1)
 //
 int
 kkill(int pid)
 {
   struct proc *p;
 
-  // 遍历进程表查找目标进程
-  for(p = proc; p < &proc[NPROC]; p++){
-    acquire(&p->lock);
-    
-    if(p->pid == pid){
-      // 找到目标进程
-      p->killed = 1;          // 设置 killed 标志
+  // 查找目标进程，找到时持有 p->lock
+  if((p = findproc(pid)) == 0)
+    return -1;                // 未找到指定 PID 的进程
+
+  p->killed = 1;              // 设置 killed 标志
       
-      if(p->state == SLEEPING){
-        // 如果进程在睡眠，唤醒它
-        // 让它有机会尽快退出
-        p->state = RUNNABLE;
-      }
+  if(p->state == SLEEPING){
+    // 如果进程在睡眠，唤醒它
+    // 让它有机会尽快退出
+    setstate(p, RUNNABLE);
+  }
       
-      release(&p->lock);
-      return 0;               // 成功
+  release(&p->lock);
+  return 0;                   // 成功
+}
+
+
+// kkillpg - 杀死进程组 pgid 中的所有进程
+
+//
+// 功能：一次调用给整个进程组设置 killed 标志，
+//       用于一次性拆除 shell 作业或工作进程池
+//
+// 参数：
+// - pgid: 目标进程组，0 表示调用者自己所在的组
+//
+// 返回值：
+// - 0: 成功
+// - -ESRCH: 进程组不存在
+// - -EINVAL: pgid 为负
+//
+// 实现：
+// - 持有 wait_lock 遍历 pghash 中的一条链，只访问组内成员
+// - 睡眠中的成员立即改为 RUNNABLE（与 kkill 相同），
+//   它在 sleep() 中醒来后自己离开睡眠队列，检查 killed 后退出
+// - 已经在 kexit 中的进程已离开进程组，不会被重复处理
+//
+int
+kkillpg(int pgid)
+{
+  struct proc *p;
+  int n = 0;
+
+  if(pgid < 0)
+    return -EINVAL;
+
+  acquire(&wait_lock);
+  if(pgid == 0)
+    pgid = myproc()->pgid;
+  for(p = pghash[PIDHASH(pgid)]; p != 0; p = p->pgnext){
+    if(p->pgid != pgid)
+      continue;
+    acquire(&p->lock);
+    p->killed = 1;
+    if(p->state == SLEEPING)
+      setstate(p, RUNNABLE);
+    release(&p->lock);
+    n++;
+  }
+  release(&wait_lock);
+  return n > 0 ? 0 : -ESRCH;
+}
+
+
+// ksetpgid - 把进程 pid 移到进程组 pgid
+
+//
+// 参数：
+// - pid: 目标进程，0 表示调用者自己；只能是自己或自己的子进程
+// - pgid: 目标进程组，0 表示以 pid 为组号新建一个组
+//
+// 返回值：
+// - 0: 成功
+// - -ESRCH: pid 不是调用者自己或它的子进程
+// - -EPERM: 目标是会话首进程，或不在同一会话，
+//           或 pgid 指定的组在本会话中不存在
+// - -EINVAL: pgid 为负
+//
+// 规则与 POSIX setpgid 一致，保证进程组不会跨越会话
+//
+int
+ksetpgid(int pid, int pgid)
+{
+  struct proc *p = myproc();
+  struct proc *t, *g;
+  int err = 0;
+
+  if(pgid < 0)
+    return -EINVAL;
+
+  acquire(&wait_lock);
+  t = p;
+  if(pid != 0 && pid != p->pid){
+    // wait_lock 保证子进程的 parent 和进程组不会变化
+    if((t = findproc(pid)) == 0){
+      release(&wait_lock);
+      return -ESRCH;
     }
-    
+    release(&t->lock);
+    if(t->parent != p || t->pgid == 0){   // 不是子进程，或已退出
+      release(&wait_lock);
+      return -ESRCH;
+    }
+  }
+  if(pgid == 0)
+    pgid = t->pid;
+
+  if(t->sid == t->pid || t->sid != p->sid){
+    err = -EPERM;
+  } else if(pgid != t->pid &&
+            ((g = pgfind(pgid)) == 0 || g->sid != p->sid)){
+    err = -EPERM;
+  } else if(t->pgid != pgid){
+    pgleave(t);
+    pgjoin(t, pgid);
+  }
+  release(&wait_lock);
+  return err;
+}
+
+
+// kgetpgid - 返回进程 pid 的进程组号，pid 为 0 表示调用者自己
+//
+// 返回值：进程组号，或 -ESRCH
+//
+int
+kgetpgid(int pid)
+{
+  struct proc *p;
+  int pgid;
+
+  acquire(&wait_lock);
+  if(pid == 0){
+    pgid = myproc()->pgid;
+  } else if((p = findproc(pid)) != 0){
+    pgid = p->pgid;
     release(&p->lock);
+  } else {
+    pgid = -ESRCH;
   }
-  
-  return -1;                  // 未找到指定 PID 的进程
+  release(&wait_lock);
+  return pgid;
+}
+
+
+// ksetsid - 新建一个会话，调用者成为会话首进程和组长
+
+//
+// 返回值：
+// - 新会话号（即调用者的 pid）
+// - -EPERM: 已有进程组以调用者的 pid 为组号（调用者已是组长）
+//
+int
+ksetsid(void)
+{
+  struct proc *p = myproc();
+  int sid;
+
+  acquire(&wait_lock);
+  if(pgfind(p->pid) != 0){
+    sid = -EPERM;
+  } else {
+    pgleave(p);
+    p->sid = p->pid;
+    pgjoin(p, p->pid);
+    sid = p->sid;
+  }
+  release(&wait_lock);
+  return sid;
 }
 
 
@@ -1500,7 +2207,7 @@ procdump(void)
   printf("\n");
   
   // 遍历所有进程（不加锁，可能不一致）
-  for(p = proc; p < &proc[NPROC]; p++){
+  for(p = allproc; p != 0; p = p->allnext){
     if(p->state == UNUSED)
       continue;               // 跳过未使用的槽位
       
@@ -63,6 +63,25 @@ struct cpu {
   int intena;                 // 在第一次 push_off() 之前，中断是否开启？
                               // 保存原始中断状态，用于 pop_off() 恢复
                               // 1 = 开启，0 = 关闭
+
+  uint64 kstackgen;           // 本 CPU 上次刷新 TLB 时的 kstackgen
+                              // 落后于全局值说明有新映射的内核栈，需要 sfence.vma
+
+  uint64 nexttick;            // 下一个时钟 tick 的 r_time()
+                              // 采样剖析开启时，两次 tick 之间还有采样中断
+
+  // 统计计数（见 sysinfo.c），只由本 CPU 在关中断时更新
+  uint64 nswitch;             // 调度器切换到进程的次数
+  uint64 nsyscall;            // 系统调用次数
+  uint64 nintr;               // 设备和时钟中断次数
+  uint64 nacquire;            // acquire 次数
+  uint64 ncontend;            // 第一次没抢到锁的 acquire 次数
+  uint64 nspin;               // 等锁时的重试次数
+
+  uint64 perfstart[NPERFCTR]; // 当前进程切换进来时的硬件计数器值（见 perf.c）
+
+  struct proc *handoff;       // 直接切换（switchto）时上一个进程，
+                              // 它的锁由切换进来的一方释放（见 finishswitch）
 };
 
 extern struct cpu cpus[NCPU];  // 所有 CPU 核心的数组（最多 NCPU 个核心）
@@ -162,6 +181,16 @@ struct trapframe {
 enum procstate { UNUSED, USED, SLEEPING, RUNNABLE, RUNNING, ZOMBIE };
 
 
+// 每个进程的调度统计，由 scheduler_debug.c 更新和输出
+struct proc_stats {
+  uint64 runtime;
+  uint64 switches;
+  uint64 wait_time;
+  uint64 last_run;
+  int priority;
+};
+
+
 // 进程控制块 (Process Control Block, PCB)
 
 //
@@ -207,6 +236,17 @@ struct proc {
   int errno;                   // 最后一次系统调用的错误码
                                // 0 表示成功，非零表示错误
                                // 兼容 POSIX errno 机制
+
+  uint64 tracemask;            // 系统调用跟踪掩码
+                               // 位 (1 << SYS_xxx) 置位表示记录该调用
+                               // 由 trace() 设置，fork 时继承
+
+  uint64 faultcnt[NFAULTTYPE];     // 本进程各类页错误的次数（见 faultstat.h）
+  uint64 faultcycles[NFAULTTYPE];  // 以及处理耗时，只由进程自己更新
+
+  uint64 perf[NPERFCTR];       // 本进程在 CPU 上期间的硬件计数（见 perf.h）
+                               // 调度器在进程切换出去时累加，持有 p->lock
+  uint64 perfchild[NPERFCTR];  // 已回收的子孙进程的计数之和，只由进程自己在 wait 中累加
   
   // MLFQ 调度器相关字段
   int mlfq_level;              // 当前所在的 MLFQ 队列级别
@@ -224,6 +264,12 @@ struct proc {
                                // Level 3: 8 ticks
                                // Level 4: 16 ticks
 
+  int mlfq_onq;                // 所在 MLFQ 队列的级别 + 1，0 表示不在队列中
+  struct proc *mlfq_next;      // MLFQ 队列链表，由队列锁保护
+  struct proc *mlfq_prev;      // （见 scheduler_ext.c）
+
+  struct proc_stats stats;     // 调度统计（见 scheduler_debug.c）
+
   //  需要持有 wait_lock 才能访问的字段 
   // wait_lock 保护父子关系，必须在 p->lock 之前获取（避免死锁）
   
@@ -231,6 +277,36 @@ struct proc {
                                // 用于进程退出时通知父进程
                                // 孤儿进程会被重新指向 init 进程
 
+  struct proc *children;       // 活着的子进程链表头
+  struct proc *zombies;        // 已退出、等待回收的子进程链表头
+  struct proc *nextsib;        // 兄弟链表（同一父进程的子进程）
+  struct proc *prevsib;        // 子进程退出时从 children 移到 zombies，
+                               // wait() 直接取 zombies 的头部
+
+  int pgid;                    // 进程组 ID，fork 时继承，setpgid() 修改
+  int sid;                     // 会话 ID，fork 时继承，setsid() 修改
+  struct proc *pgnext;         // 进程组哈希链（见 kkillpg），双向链表，
+  struct proc *pgprev;         // 退出时 O(1) 离开进程组
+
+  //  需要持有所在睡眠队列的锁才能访问的字段 
+
+  struct sleepq *sq;           // 正在睡眠的队列，不在队列上时为 0
+  struct proc *sqnext;         // 同一睡眠队列中的进程（见 wakeup）
+  struct proc *sqprev;
+
+  //  需要持有 pid_lock 才能访问的字段 
+
+  struct proc *pidnext;        // pid 哈希链（见 findproc）
+
+  //  进程表字段，需要持有 proctab_lock 
+
+  struct proc *nextfree;       // 空闲链表（state == UNUSED 时有效）
+
+  //  创建后不再改变的字段 
+
+  struct proc *allnext;        // 所有 proc 结构体的链表（见 allproc）
+  int idx;                     // 创建序号，决定内核栈地址 KSTACK(idx)
+
   //  进程私有字段，无需加锁 
   // 这些字段只被进程自己访问，不会有并发问题
   
@@ -257,10 +333,11 @@ struct proc {
                                // swtch(&p->context, &c->context) 时保存/恢复
                                // 用于进程切换时保存内核执行状态
                                
-  struct file *ofile[NOFILE];  // 打开的文件描述符数组
-                               // ofile[fd] 指向对应的 file 结构体
+  struct fdpage *fdtab[NFDPAGE]; // 打开的文件描述符表（见 fdtable.c）
+                               // 按页分配，每页 504 个 fd，用 fdlookup() 查找
                                // fd 0: 标准输入，fd 1: 标准输出，fd 2: 标准错误
-                               // 最多可以打开 NOFILE (16) 个文件
+  uint64 fdfull;               // 位 i 置位表示 fdtab[i] 已占满
+  int fdlimit;                 // 打开文件数上限，默认 NOFILE，fork 时继承
                                
   struct inode *cwd;           // 当前工作目录 (Current Working Directory)
                                // 指向当前目录的 inode
@@ -270,3 +347,9 @@ struct proc {
                                // 通常是可执行文件的名字
                                // 在 ps 命令或 procdump() 中显示
 };
+
+// 所有创建过的 proc 结构体，包括 UNUSED 的
+// proc 结构体从不释放，只回到空闲链表，所以可以不加锁遍历：
+//   for(p = allproc; p != 0; p = p->allnext)
+// 遍历时要看进程状态，仍需像原来一样获取 p->lock
+extern struct proc *allproc;
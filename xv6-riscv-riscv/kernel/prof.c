@@ -0,0 +1,176 @@
+// kernel/prof.c - 时钟中断驱动的采样剖析器
+
+//
+// 功能：
+// - prof(hz) 开启后，每个 CPU 以 hz 的频率采样被打断的代码：
+//   pc、用户态/内核态、进程、帧指针回溯（见 prof.h）
+// - 用户程序通过 profread() 取走记录（见 user/prof.c），
+//   主机上用 prof2folded.py 对照 kernel.sym / user/*.sym
+//   符号化，生成火焰图用的折叠栈
+//
+// 定时：
+// - 时钟 tick 仍是每 1000000 个 time 计数一次；采样开启后
+//   clockintr() 把 stimecmp 设为下一个 tick 和下一次采样中较早的一个，
+//   两次 tick 之间的中断只采样，不推进 ticks、不触发调度
+// - 其他 CPU 在各自的下一个 tick 之后才切换到新的采样频率
+//
+// 记录：
+// - 采样在 usertrap()/kerneltrap() 中进行，中断是关闭的，
+//   写入本 CPU 的无锁环（见 ring.c）
+//
+
+#include "types.h"
+#include "param.h"
+#include "memlayout.h"
+#include "riscv.h"
+#include "spinlock.h"
+#include "proc.h"
+#include "defs.h"
+#include "errno.h"
+#include "prof.h"
+#include "ring.h"
+
+static struct profent profents[NCPU][PROF_NENT] __attribute__((aligned(64)));
+static struct ring profring = RING_INIT(profents);
+
+static int profhz;              // 当前采样频率，0 表示关闭
+static uint64 profinterval;     // 采样间隔（time 计数），0 表示关闭
+
+
+// profnext - 返回下一次时钟中断的时间
+//
+// 参数：
+//   tick: 下一个时钟 tick 的 r_time()
+//
+// 采样开启且下一次采样早于 tick 时返回采样时间，否则返回 tick
+//
+uint64
+profnext(uint64 tick)
+{
+  uint64 iv = __atomic_load_n(&profinterval, __ATOMIC_RELAXED);
+  uint64 t;
+
+  if(iv == 0)
+    return tick;
+  t = r_time() + iv;
+  return t < tick ? t : tick;
+}
+
+// 读取栈上 va 处的 8 字节，读不到时返回 -1
+//
+// 用户栈（pagetable 非 0）通过页表读取，不能用 copyin：
+// 它会为惰性分配的页分配内存。内核栈只有一页，前后是保护页，
+// 所以 va 必须落在 [lo, hi) 内。
+//
+static int
+readword(pagetable_t pagetable, uint64 lo, uint64 hi, uint64 va, uint64 *out)
+{
+  uint64 pa;
+
+  if(va % 8)
+    return -1;
+  if(pagetable){
+    if((pa = walkaddr(pagetable, PGROUNDDOWN(va))) == 0)
+      return -1;
+    *out = *(uint64*)(pa + va % PGSIZE);
+  } else {
+    if(va < lo || va + 8 > hi)
+      return -1;
+    *out = *(uint64*)va;
+  }
+  return 0;
+}
+
+// 沿帧指针回溯，结果写入 e->stack / e->depth
+//
+// 栈向下增长，调用者的 fp 一定更高，不满足说明帧链已断。
+//
+// 叶子函数不保存 ra，fp-8 处直接是调用者的 fp，返回地址还在
+// ra 寄存器里。代码总在栈的下方，所以 fp-8 处的值不小于 fp
+// 时按叶子帧处理。
+//
+static void
+backtrace(struct profent *e, uint64 fp, uint64 ra0, pagetable_t pagetable)
+{
+  uint64 lo = PGROUNDDOWN(fp - 16), hi = lo + PGSIZE;
+  uint64 ra, prev;
+  int n = 0;
+
+  if(readword(pagetable, lo, hi, fp - 8, &prev) == 0 && prev >= fp){
+    e->stack[n++] = ra0;
+    fp = prev;
+  }
+
+  while(n < PROF_DEPTH && fp != 0){
+    if(readword(pagetable, lo, hi, fp - 8, &ra) < 0 ||
+       readword(pagetable, lo, hi, fp - 16, &prev) < 0 || ra == 0)
+      break;
+    e->stack[n++] = ra;
+    if(prev <= fp)
+      break;
+    fp = prev;
+  }
+  e->depth = n;
+}
+
+// profintr - 时钟中断中记录一次采样（由 usertrap/kerneltrap 调用）
+//
+// 参数：
+//   pc:   被打断的指令地址
+//   fp:   被打断时的 s0
+//   ra:   被打断时的 ra（只在叶子函数中用到）
+//   user: 是否来自用户态
+//
+void
+profintr(uint64 pc, uint64 fp, uint64 ra, int user)
+{
+  struct profent *e;
+  struct proc *p;
+
+  if(__atomic_load_n(&profinterval, __ATOMIC_RELAXED) == 0)
+    return;
+
+  e = ring_reserve(&profring);
+  p = myproc();
+  e->pc = pc;
+  e->user = user;
+  e->cpu = cpuid();
+  e->pid = p ? p->pid : 0;
+  safestrcpy(e->name, p ? p->name : "scheduler", sizeof(e->name));
+  backtrace(e, fp, ra, user ? p->pagetable : 0);
+  ring_publish(&profring);
+}
+
+
+// profset - 设置采样频率
+//
+// 参数：
+//   hz: 每秒每个 CPU 的采样数，1 到 PROF_MAXHZ；0 关闭采样；
+//       负数只查询
+//
+// 返回值：原来的频率，或 -EINVAL
+//
+int
+profset(int hz)
+{
+  int old = profhz;
+
+  if(hz < 0)
+    return old;
+  if(hz > PROF_MAXHZ)
+    return -EINVAL;
+  profhz = hz;
+  __atomic_store_n(&profinterval, hz ? TIMEBASE_FREQ / hz : 0, __ATOMIC_RELAXED);
+  return old;
+}
+
+
+// profread - 把所有 CPU 环中的采样复制到用户空间
+//
+// 参数和返回值见 ring_read（ubuf 是 struct profent 数组）
+//
+int
+profread(uint64 ubuf, int n, uint64 ulost)
+{
+  return ring_read(&profring, ubuf, n, ulost);
+}
@@ -0,0 +1,22 @@
+// 采样剖析记录，内核 prof.c 在时钟中断中写入，用户态 profread() 读出。
+//
+// 每次采样记录被打断的 pc、用户态还是内核态、当前进程，
+// 以及沿帧指针（s0）回溯得到的最多 PROF_DEPTH 个返回地址。
+// 内核和用户程序都以 -fno-omit-frame-pointer 编译，
+// 每个栈帧中 fp-8 处是返回地址，fp-16 处是调用者的 fp。
+//
+#define PROF_NENT    512       // 每个 CPU 的环形缓冲区记录数（2 的幂）
+#define PROF_DEPTH   8         // 回溯的最大深度
+
+#define PROF_MAXHZ   10000     // prof() 允许的最高采样频率
+
+struct profent {
+  uint64 pc;                   // 被打断的指令地址（sepc）
+  uint64 stack[PROF_DEPTH];    // 返回地址，stack[0] 是 pc 所在函数的调用点
+  int pid;                     // 当前进程，0 表示调度器（空闲）
+  uchar user;                  // 1 = 用户态，0 = 内核态
+  uchar depth;                 // stack 中的有效项数
+  uchar cpu;                   // 采样的 CPU
+  uchar pad;
+  char name[16];               // 进程名，用于在主机上找对应的 .sym
+};
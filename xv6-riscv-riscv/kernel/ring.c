@@ -0,0 +1,169 @@
+// kernel/ring.c - 每 CPU 无锁记录环
+
+//
+// 系统调用跟踪（trace.c）、内核日志（klog.c）、采样剖析（prof.c）
+// 和静态跟踪点（tracepoint.c）共用这里的环，各自只定义记录格式
+//
+// 写入端（无锁）：
+// - 每个 CPU 独占一个环，ring_reserve 到 ring_publish 之间关中断，
+//   同一时刻每个环最多只有一个写者，不需要自旋锁
+// - 先推进 wseq 再写槽位，写完再发布 head，
+//   读者据此判断刚复制的槽位是否被并发覆盖（类似 seqlock）
+// - 写满后覆盖最旧的记录
+//
+// 读出端：
+// - ring_read 消耗记录，同一时刻只允许一个读者（draining 标志），
+//   其余返回 -EBUSY；读者不持锁复制，复制后再检查 wseq，
+//   被覆盖的记录丢弃并计入 lost
+// - ring_head/ring_slot/ring_snapshot 供自己维护读游标的使用者
+//   （klog.c 的控制台输出和 dmesg）按序号读取，不消耗记录
+//
+
+#include "types.h"
+#include "param.h"
+#include "memlayout.h"
+#include "riscv.h"
+#include "spinlock.h"
+#include "proc.h"
+#include "defs.h"
+#include "errno.h"
+#include "ring.h"
+
+
+// ring_slot - CPU cpu 的环中序号 i 所在的槽位
+//
+void*
+ring_slot(struct ring *r, int cpu, uint64 i)
+{
+  return r->ent + ((uint64)cpu * r->nent + (i & (r->nent - 1))) * r->esize;
+}
+
+
+// ring_reserve - 在本 CPU 的环中取下一个槽位
+//
+// 返回值：槽位地址，调用者填好后必须调用 ring_publish
+//
+// 关中断直到 ring_publish，期间不能睡眠
+//
+void*
+ring_reserve(struct ring *r)
+{
+  struct ringcpu *rc;
+  int cpu;
+
+  push_off();
+  cpu = cpuid();
+  rc = &r->cpu[cpu];
+
+  // 先声明要写槽位 head，读者看到 wseq 后就会丢弃该槽位的旧内容
+  rc->wseq = rc->head + 1;
+  __sync_synchronize();
+
+  return ring_slot(r, cpu, rc->head);
+}
+
+
+// ring_publish - 发布 ring_reserve 取得的槽位
+//
+void
+ring_publish(struct ring *r)
+{
+  struct ringcpu *rc = &r->cpu[cpuid()];
+
+  __atomic_store_n(&rc->head, rc->head + 1, __ATOMIC_RELEASE);
+  pop_off();
+}
+
+
+// ring_head - CPU cpu 的环已发布的记录数
+//
+// 仍保留的记录序号是 [head - nent, head)
+//
+uint64
+ring_head(struct ring *r, int cpu)
+{
+  return __atomic_load_n(&r->cpu[cpu].head, __ATOMIC_ACQUIRE);
+}
+
+
+// 复制后检查：写者已开始写序号 i + nent（同一槽位）则复制的内容不可信
+static int
+overwritten(struct ring *r, int cpu, uint64 i)
+{
+  __sync_synchronize();
+  return __atomic_load_n(&r->cpu[cpu].wseq, __ATOMIC_RELAXED) - i > r->nent;
+}
+
+
+// ring_snapshot - 把 CPU cpu 的环中序号 i 的记录复制到 dst
+//
+// 返回值：0 成功，-1 表示复制期间被覆盖
+//
+int
+ring_snapshot(struct ring *r, int cpu, uint64 i, void *dst)
+{
+  memmove(dst, ring_slot(r, cpu, i), r->esize);
+  return overwritten(r, cpu, i) ? -1 : 0;
+}
+
+
+// ring_read - 把所有 CPU 环中未读的记录复制到用户空间
+//
+// 参数：
+//   ubuf:  用户缓冲区（记录数组）
+//   n:     缓冲区容量（记录数）
+//   ulost: 若非 0，写入自上次读出以来丢失的记录数
+//
+// 返回值：
+//   >= 0:    复制的记录数（按 CPU 分组，组内按时间顺序）
+//   -EBUSY:  已有其他进程在读
+//   -EFAULT: 用户地址非法
+//
+// 记录直接从槽位复制到用户缓冲区，再检查是否被覆盖；
+// 被覆盖的不计数，下一条记录会写到它的位置上
+//
+int
+ring_read(struct ring *r, uint64 ubuf, int n, uint64 ulost)
+{
+  struct proc *p = myproc();
+  int cnt = 0;
+
+  if(__sync_lock_test_and_set(&r->draining, 1) != 0)
+    return -EBUSY;
+
+  for(int c = 0; c < NCPU && cnt < n; c++){
+    struct ringcpu *rc = &r->cpu[c];
+    uint64 head = ring_head(r, c);
+    uint64 i = rc->tail;
+
+    if(head - i > r->nent){
+      r->lost += head - i - r->nent;
+      i = head - r->nent;
+    }
+    for(; i < head && cnt < n; i++){
+      if(copyout(p->pagetable, ubuf + (uint64)cnt * r->esize,
+                 ring_slot(r, c, i), r->esize) < 0){
+        cnt = -EFAULT;
+        break;
+      }
+      if(overwritten(r, c, i)){
+        r->lost++;
+        continue;
+      }
+      cnt++;
+    }
+    rc->tail = i;
+    if(cnt < 0)
+      break;
+  }
+
+  if(cnt >= 0 && ulost){
+    if(copyout(p->pagetable, ulost, (char *)&r->lost, sizeof(r->lost)) < 0)
+      cnt = -EFAULT;
+    else
+      r->lost = 0;
+  }
+
+  __sync_lock_release(&r->draining);
+  return cnt;
+}
@@ -0,0 +1,25 @@
+// 每 CPU 无锁记录环，实现见 ring.c。
+//
+// 使用者提供 [NCPU][nent] 的记录数组，用 RING_INIT 定义环：
+//
+//   static struct traceent traceents[NCPU][TRACE_NENT];
+//   static struct ring tracering = RING_INIT(traceents);
+//
+
+struct ringcpu {
+  uint64 wseq;        // 正在写入的序号 + 1（写者在写槽位前推进）
+  uint64 head;        // 已发布的记录数（写者在写完槽位后推进）
+  uint64 tail;        // 下一条待读记录的序号（只有 ring_read 修改）
+} __attribute__((aligned(64)));
+
+struct ring {
+  char *ent;          // 记录数组，CPU c 的第 i 条在 (c * nent + i % nent) * esize
+  uint esize;         // 每条记录的字节数
+  uint nent;          // 每个 CPU 的记录数（2 的幂）
+  int draining;       // 是否有读者正在 ring_read
+  uint64 lost;        // 被覆盖或读出时损坏的记录数（读者独占修改）
+  struct ringcpu cpu[NCPU];
+};
+
+#define RING_INIT(ent) { \
+  (char *)(ent), sizeof((ent)[0][0]), sizeof((ent)[0]) / sizeof((ent)[0][0]) }
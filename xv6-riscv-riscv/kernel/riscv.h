@@ -15,6 +15,7 @@ r_mhartid()
 #define MSTATUS_MPP_M (3L << 11)
 #define MSTATUS_MPP_S (1L << 11)
 #define MSTATUS_MPP_U (0L << 11)
+#define MSTATUS_VS_INIT (1L << 9) // vector unit on, state Initial
 
 static inline uint64
 r_mstatus()
@@ -30,6 +31,17 @@ w_mstatus(uint64 x)
   asm volatile("csrw mstatus, %0" : : "r" (x));
 }
 
+// Machine ISA Register, one bit per extension letter.
+#define MISA_V (1L << ('V' - 'A'))
+
+static inline uint64
+r_misa()
+{
+  uint64 x;
+  asm volatile("csrr %0, misa" : "=r" (x) );
+  return x;
+}
+
 // machine exception program counter, holds the
 // instruction address to which a return from
 // exception will go.
@@ -258,8 +270,22 @@ r_stval()
   return x;
 }
 
+// Counter-Enable bits, shared by mcounteren and scounteren.
+// a set bit lets the next lower privilege mode read the counter.
+#define COUNTEREN_CY (1L << 0) // cycle
+#define COUNTEREN_TM (1L << 1) // time
+#define COUNTEREN_IR (1L << 2) // instret
+#define COUNTEREN_HPM(n) (1L << (n)) // hpmcounter3..31
+
+// mhpmevent values, in the SBI PMU event encoding that
+// qemu's virt machine counts. other machines may count
+// something else, or nothing.
+#define HPMEVENT_DTLB_READ_MISS  0x10019
+#define HPMEVENT_DTLB_WRITE_MISS 0x1001b
+#define HPMEVENT_ITLB_MISS       0x10021
+
 // Machine-mode Counter-Enable
-static inline void 
+static inline void
 w_mcounteren(uint64 x)
 {
   asm volatile("csrw mcounteren, %0" : : "r" (x));
@@ -273,6 +299,21 @@ r_mcounteren()
   return x;
 }
 
+// Supervisor-mode Counter-Enable
+static inline void
+w_scounteren(uint64 x)
+{
+  asm volatile("csrw scounteren, %0" : : "r" (x));
+}
+
+static inline uint64
+r_scounteren()
+{
+  uint64 x;
+  asm volatile("csrr %0, scounteren" : "=r" (x) );
+  return x;
+}
+
 // machine-mode cycle counter
 static inline uint64
 r_time()
@@ -282,6 +323,68 @@ r_time()
   return x;
 }
 
+// cpu clock cycles retired since reset
+static inline uint64
+r_cycle()
+{
+  uint64 x;
+  asm volatile("csrr %0, cycle" : "=r" (x) );
+  return x;
+}
+
+// programmable counters; the event each one counts is
+// selected in machine mode by the matching mhpmevent.
+static inline void
+w_mhpmevent3(uint64 x)
+{
+  asm volatile("csrw mhpmevent3, %0" : : "r" (x));
+}
+
+static inline void
+w_mhpmevent4(uint64 x)
+{
+  asm volatile("csrw mhpmevent4, %0" : : "r" (x));
+}
+
+static inline void
+w_mhpmevent5(uint64 x)
+{
+  asm volatile("csrw mhpmevent5, %0" : : "r" (x));
+}
+
+static inline uint64
+r_hpmcounter3()
+{
+  uint64 x;
+  asm volatile("csrr %0, hpmcounter3" : "=r" (x) );
+  return x;
+}
+
+static inline uint64
+r_hpmcounter4()
+{
+  uint64 x;
+  asm volatile("csrr %0, hpmcounter4" : "=r" (x) );
+  return x;
+}
+
+static inline uint64
+r_hpmcounter5()
+{
+  uint64 x;
+  asm volatile("csrr %0, hpmcounter5" : "=r" (x) );
+  return x;
+}
+
+// instructions retired since reset
+static inline uint64
+r_instret()
+{
+  uint64 x;
+  asm volatile("csrr %0, instret" : "=r" (x) );
+  return x;
+}
+
 // enable device interrupts
 static inline void
 intr_on()
@@ -328,6 +431,16 @@ w_tp(uint64 x)
   asm volatile("mv tp, %0" : : "r" (x));
 }
 
+// frame pointer; with -fno-omit-frame-pointer, the return
+// address is at fp-8 and the caller's fp at fp-16.
+static inline uint64
+r_fp()
+{
+  uint64 x;
+  asm volatile("mv %0, s0" : "=r" (x) );
+  return x;
+}
+
 static inline uint64
 r_ra()
 {
@@ -10,9 +10,6 @@
 #include "defs.h"
 #include <stdint.h>
 
-// 外部变量声明
-extern struct proc proc[NPROC];
-
 // 调度统计信息
 struct scheduler_stats {
   uint64 total_switches;
@@ -24,17 +21,8 @@ struct scheduler_stats {
 
 static struct scheduler_stats sched_stats;
 
-// 进程统计信息
-struct proc_stats {
-  uint64 runtime;
-  uint64 switches;
-  uint64 wait_time;
-  uint64 last_run;
-  int priority;
-};
-
-// 全局统计
-static struct proc_stats proc_stats[NPROC];
+// 进程统计信息在 p->stats 中（见 proc.h），随 proc 结构体创建，
+// allocproc 时清零
 
 // 初始化调试系统
 void
@@ -45,15 +33,6 @@ scheduler_debug_init(void)
   sched_stats.total_runtime = 0;
   sched_stats.idle_time = 0;
   sched_stats.context_switch_time = 0;
-  
-  // 初始化进程统计
-  for(int i = 0; i < NPROC; i++) {
-    proc_stats[i].runtime = 0;
-    proc_stats[i].switches = 0;
-    proc_stats[i].wait_time = 0;
-    proc_stats[i].last_run = 0;
-    proc_stats[i].priority = 0;
-  }
 }
 
 // 更新调度统计
@@ -71,13 +50,12 @@ update_scheduler_stats(uint64 switch_time, uint64 runtime)
 void
 update_proc_stats(struct proc *p, uint64 runtime, uint64 wait_time)
 {
-  if(p->pid < 0 || p->pid >= NPROC)
-    return;
-    
-  proc_stats[p->pid].runtime += runtime;
-  proc_stats[p->pid].switches++;
-  proc_stats[p->pid].wait_time += wait_time;
-  proc_stats[p->pid].last_run = 0; // 临时值，需要实现r_time()
+  struct proc_stats *st = &p->stats;
+
+  st->runtime += runtime;
+  st->switches++;
+  st->wait_time += wait_time;
+  st->last_run = 0; // 临时值，需要实现r_time()
 }
 
 // 输出进程表调试信息
@@ -86,17 +64,16 @@ debug_proc_table(void)
 {
   printf("=== Process Table Debug ===\n");
   
-  for(int i = 0; i < NPROC; i++) {
-    struct proc *p = &proc[i];
+  for(struct proc *p = allproc; p != 0; p = p->allnext) {
     acquire(&p->lock);
     
     if(p->state != UNUSED) {
       printf("PID: %d, State: %d, Name: %s\n", 
              p->pid, p->state, p->name);
       printf("  Runtime: %lu, Switches: %lu\n",
-             proc_stats[i].runtime, proc_stats[i].switches);
+             p->stats.runtime, p->stats.switches);
       printf("  Wait time: %lu, Priority: %d\n",
-             proc_stats[i].wait_time, proc_stats[i].priority);
+             p->stats.wait_time, p->stats.priority);
     }
     
     release(&p->lock);
@@ -130,12 +107,11 @@ analyze_scheduling_latency(void)
   uint64 total_latency = 0;
   int count = 0;
   
-  for(int i = 0; i < NPROC; i++) {
-    struct proc *p = &proc[i];
+  for(struct proc *p = allproc; p != 0; p = p->allnext) {
     acquire(&p->lock);
     
-    if(p->state != UNUSED && proc_stats[i].switches > 0) {
-      uint64 avg_latency = proc_stats[i].wait_time / proc_stats[i].switches;
+    if(p->state != UNUSED && p->stats.switches > 0) {
+      uint64 avg_latency = p->stats.wait_time / p->stats.switches;
       
       if(avg_latency > max_latency)
         max_latency = avg_latency;
@@ -167,8 +143,7 @@ detect_resource_leaks(void)
   int runnable_processes = 0;
   int sleeping_processes = 0;
   
-  for(int i = 0; i < NPROC; i++) {
-    struct proc *p = &proc[i];
+  for(struct proc *p = allproc; p != 0; p = p->allnext) {
     acquire(&p->lock);
     
     if(p->state != UNUSED) {
@@ -215,13 +190,12 @@ performance_analysis(void)
   uint64 total_wait_time = 0;
   int process_count = 0;
   
-  for(int i = 0; i < NPROC; i++) {
-    struct proc *p = &proc[i];
+  for(struct proc *p = allproc; p != 0; p = p->allnext) {
     acquire(&p->lock);
     
     if(p->state != UNUSED) {
-      total_cpu_time += proc_stats[i].runtime;
-      total_wait_time += proc_stats[i].wait_time;
+      total_cpu_time += p->stats.runtime;
+      total_wait_time += p->stats.wait_time;
       process_count++;
     }
     
@@ -245,14 +219,13 @@ scheduler_health_check(void)
   int issues = 0;
   
   // 检查是否有死锁
-  for(int i = 0; i < NPROC; i++) {
-    struct proc *p = &proc[i];
+  for(struct proc *p = allproc; p != 0; p = p->allnext) {
     acquire(&p->lock);
     
     if(p->state == RUNNABLE) {
       // 检查进程是否长时间处于可运行状态
       uint64 current_time = 0; // 临时值，需要实现r_time()
-      if(current_time - proc_stats[i].last_run > 1000000) { // 1秒
+      if(current_time - p->stats.last_run > 1000000) { // 1秒
         printf("WARNING: Process %d has been runnable for too long\n", p->pid);
         issues++;
       }
@@ -288,8 +261,7 @@ real_time_monitoring(void)
     int runnable_count = 0;
     int running_count = 0;
     
-    for(int j = 0; j < NPROC; j++) {
-      struct proc *p = &proc[j];
+    for(struct proc *p = allproc; p != 0; p = p->allnext) {
       acquire(&p->lock);
       
       if(p->state == RUNNABLE) runnable_count++;
@@ -318,8 +290,7 @@ monitor_memory_usage(void)
   // 由于xv6的内存管理相对简单，主要监控进程数量
   int active_count = 0;
   
-  for(int i = 0; i < NPROC; i++) {
-    struct proc *p = &proc[i];
+  for(struct proc *p = allproc; p != 0; p = p->allnext) {
     acquire(&p->lock);
     
     if(p->state != UNUSED) {
@@ -26,16 +26,18 @@
 #include "proc.h"
 #include "defs.h"
 
-// 外部变量声明
-extern struct proc proc[NPROC];
-
 
 // 优先级调度器数据结构
 
+//
+// 队列是串在 proc 上的双向链表（p->mlfq_next/mlfq_prev），
+// 不随 NPROC 增长，入队出队都是 O(1)
+//
 struct priority_queue {
-  struct proc *processes[NPROC];  // 进程指针数组
+  struct proc *head;              // 队首（最早入队）
+  struct proc *tail;              // 队尾
   int count;                      // 当前进程数量
-  struct spinlock lock;           // 保护队列的锁
+  struct spinlock lock;           // 保护队列和其中进程的链表指针
 };
 
 
@@ -83,6 +85,8 @@ scheduler_init(void)
   // 初始化 MLFQ 的每个优先级队列
   for(int i = 0; i < MAX_PRIORITY_LEVELS; i++) {
     initlock(&mlfq_sched.queues[i].lock, "mlfq_queue");
+    mlfq_sched.queues[i].head = 0;
+    mlfq_sched.queues[i].tail = 0;
     mlfq_sched.queues[i].count = 0;
     
     // 时间片呈指数增长：1, 2, 4, 8, 16 ticks
@@ -100,7 +104,7 @@ scheduler_init(void)
 //
 // 算法：选择优先级最高的 RUNNABLE 进程
 //
-// 时间复杂度：O(n)，遍历所有进程
+// 时间复杂度：O(n)，遍历 allproc 链表
 //
 // 优点：
 // - 重要进程优先执行
@@ -121,7 +125,7 @@ priority_scheduler(void)
   int highest_priority = -1;   // 当前最高优先级
   
   // 遍历所有进程，查找优先级最高的
-  for(struct proc *p = proc; p < &proc[NPROC]; p++) {
+  for(struct proc *p = allproc; p != 0; p = p->allnext) {
     acquire(&p->lock);
     
     if(p->state == RUNNABLE) {
@@ -184,7 +188,7 @@ mlfq_scheduler(void)
     // 检查此级队列是否有进程
     if(mlfq_sched.queues[level].count > 0) {
       // 选择队列中的第一个进程（FIFO）
-      selected = mlfq_sched.queues[level].processes[0];
+      selected = mlfq_sched.queues[level].head;
       mlfq_sched.current_level = level;
       
       release(&mlfq_sched.queues[level].lock);
@@ -279,21 +283,33 @@ adjust_process_priority(struct proc *p, int new_priority)
 // - 进程用完时间片后降级
 // - 进程主动让出 CPU 后可能提升
 //
+// 进程同一时间最多在一个队列中（p->mlfq_onq），已在队列中时忽略
+//
 void
 mlfq_add_process(struct proc *p, int level)
 {
+  struct priority_queue *q;
+
   if(level < 0 || level >= MAX_PRIORITY_LEVELS) return;
   if(p == 0) return;
   
-  acquire(&mlfq_sched.queues[level].lock);
+  q = &mlfq_sched.queues[level];
+  acquire(&q->lock);
   
-  // 检查队列是否已满
-  if(mlfq_sched.queues[level].count < NPROC) {
-    mlfq_sched.queues[level].processes[mlfq_sched.queues[level].count] = p;
-    mlfq_sched.queues[level].count++;
+  if(p->mlfq_onq == 0) {
+    // 挂到队尾
+    p->mlfq_next = 0;
+    p->mlfq_prev = q->tail;
+    if(q->tail)
+      q->tail->mlfq_next = p;
+    else
+      q->head = p;
+    q->tail = p;
+    q->count++;
+    p->mlfq_onq = level + 1;
   }
   
-  release(&mlfq_sched.queues[level].lock);
+  release(&q->lock);
 }
 
 // 从 MLFQ 队列中移除进程
@@ -306,28 +322,36 @@ mlfq_add_process(struct proc *p, int level)
 // - 进程退出时
 // - 进程在队列间移动时
 //
+// p->mlfq_onq 只在持有对应队列锁时改变，所以持有 level 的锁
+// 就能判断 p 是否在这一级；不在时什么都不做
+//
 void
 mlfq_remove_process(struct proc *p, int level)
 {
+  struct priority_queue *q;
+
   if(level < 0 || level >= MAX_PRIORITY_LEVELS) return;
   if(p == 0) return;
   
-  acquire(&mlfq_sched.queues[level].lock);
+  q = &mlfq_sched.queues[level];
+  acquire(&q->lock);
   
-  // 在队列中查找并移除
-  for(int i = 0; i < mlfq_sched.queues[level].count; i++) {
-    if(mlfq_sched.queues[level].processes[i] == p) {
-      // 找到了，移除（将后续元素前移）
-      for(int j = i; j < mlfq_sched.queues[level].count - 1; j++) {
-        mlfq_sched.queues[level].processes[j] = 
-          mlfq_sched.queues[level].processes[j + 1];
-      }
-      mlfq_sched.queues[level].count--;
-      break;
-    }
+  if(p->mlfq_onq == level + 1) {
+    // 从链表中摘下
+    if(p->mlfq_prev)
+      p->mlfq_prev->mlfq_next = p->mlfq_next;
+    else
+      q->head = p->mlfq_next;
+    if(p->mlfq_next)
+      p->mlfq_next->mlfq_prev = p->mlfq_prev;
+    else
+      q->tail = p->mlfq_prev;
+    p->mlfq_next = p->mlfq_prev = 0;
+    q->count--;
+    p->mlfq_onq = 0;
   }
   
-  release(&mlfq_sched.queues[level].lock);
+  release(&q->lock);
 }
 
 
@@ -21,6 +21,8 @@ initlock(struct spinlock *lk, char *name)
 void
 acquire(struct spinlock *lk)
 {
+  struct cpu *c;
+
   push_off(); // disable interrupts to avoid deadlock.
   if(holding(lk))
     panic("acquire");
@@ -29,8 +31,13 @@ acquire(struct spinlock *lk)
   //   a5 = 1
   //   s1 = &lk->locked
   //   amoswap.w.aq a5, a5, (s1)
-  while(__sync_lock_test_and_set(&lk->locked, 1) != 0)
-    ;
+  c = mycpu();
+  c->nacquire++;
+  if(__sync_lock_test_and_set(&lk->locked, 1) != 0){
+    c->ncontend++;
+    while(__sync_lock_test_and_set(&lk->locked, 1) != 0)
+      c->nspin++;
+  }
 
   // Tell the C compiler and the processor to not move loads or stores
   // past this point, to ensure that the critical section's memory
@@ -42,6 +49,22 @@ acquire(struct spinlock *lk)
   lk->cpu = mycpu();
 }
 
+// Try to acquire the lock without spinning.
+// Returns 1 if it was acquired, 0 if some CPU
+// (possibly this one) already holds it.
+int
+tryacquire(struct spinlock *lk)
+{
+  push_off();
+  if(holding(lk) || __sync_lock_test_and_set(&lk->locked, 1) != 0){
+    pop_off();
+    return 0;
+  }
+  __sync_synchronize();
+  lk->cpu = mycpu();
+  return 1;
+}
+
 // Release the lock.
 void
 release(struct spinlock *lk)
@@ -6,6 +6,7 @@
 
 void main();
 void timerinit();
+void counterinit();
 
 // entry.S needs one stack per CPU.
 __attribute__ ((aligned (16))) char stack0[4096 * NCPU];
@@ -40,6 +41,19 @@ start()
   // ask for clock interrupts.
   timerinit();
 
+  // start the hardware performance counters.
+  counterinit();
+
+#ifdef RVV
+  // turn on the vector unit for string.c, if there is one.
+  // sstatus.VS is a view of the same field.
+  if(r_misa() & MISA_V){
+    extern int rvv_enabled;
+    w_mstatus(r_mstatus() | MSTATUS_VS_INIT);
+    rvv_enabled = 1;
+  }
+#endif
+
   // keep each CPU's hartid in its tp register, for cpuid().
   int id = r_mhartid();
   w_tp(id);
@@ -58,9 +72,23 @@ timerinit()
   // enable the sstc extension (i.e. stimecmp).
   w_menvcfg(r_menvcfg() | (1L << 63)); 
   
-  // allow supervisor to use stimecmp and time.
-  w_mcounteren(r_mcounteren() | 2);
+  // allow supervisor to use stimecmp and time, and to read
+  // cycle/instret; trapinithart() passes these on to user mode.
+  w_mcounteren(r_mcounteren() | COUNTEREN_CY | COUNTEREN_TM | COUNTEREN_IR);
   
   // ask for the very first timer interrupt.
   w_stimecmp(r_time() + 1000000);
 }
+
+// select the events counted by hpmcounter3..5, which the
+// kernel virtualizes per process (see perf.c), and let
+// supervisor mode read them.
+void
+counterinit()
+{
+  w_mhpmevent3(HPMEVENT_DTLB_READ_MISS);
+  w_mhpmevent4(HPMEVENT_DTLB_WRITE_MISS);
+  w_mhpmevent5(HPMEVENT_ITLB_MISS);
+  w_mcounteren(r_mcounteren() | COUNTEREN_HPM(3) | COUNTEREN_HPM(4) |
+               COUNTEREN_HPM(5));
+}
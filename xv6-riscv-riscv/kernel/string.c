@@ -1,13 +1,100 @@
 #include "types.h"
+#include "riscv.h"
+#include "fs.h"
+
+// memset, memcmp and memmove work a word (8 bytes) at a time
+// once the pointers are aligned. memmove and memcmp fall back
+// to bytes when src and dst are not aligned to each other.
+//
+// built with RVV=1, large memset/memmove calls use the vector
+// unit when start() found one.
+
+#define WSIZE sizeof(uint64)
+#define WMASK (WSIZE - 1)
+
+// a word that may alias any other type.
+typedef uint64 __attribute__((may_alias)) word;
+
+#ifdef RVV
+int rvv_enabled;            // set by start() if misa has V
+#define RVV_MIN 256         // smaller calls are not worth it
+
+// the vector registers are not saved across traps, so the
+// loops run with interrupts off: a device interrupt handler
+// may itself call memmove.
+static void
+rvv_copy(uchar *d, const uchar *s, uint64 n)
+{
+  uint64 vl;
+  int on = intr_get();
+
+  intr_off();
+  for(; n > 0; n -= vl, s += vl, d += vl){
+    asm volatile(".option push\n"
+                 ".option arch, +v\n"
+                 "vsetvli %0, %1, e8, m8, ta, ma\n"
+                 "vle8.v v0, (%2)\n"
+                 "vse8.v v0, (%3)\n"
+                 ".option pop"
+                 : "=&r" (vl) : "r" (n), "r" (s), "r" (d) : "memory");
+  }
+  if(on)
+    intr_on();
+}
+
+static void
+rvv_set(uchar *d, int c, uint64 n)
+{
+  uint64 vl;
+  int on = intr_get();
+
+  intr_off();
+  for(; n > 0; n -= vl, d += vl){
+    asm volatile(".option push\n"
+                 ".option arch, +v\n"
+                 "vsetvli %0, %1, e8, m8, ta, ma\n"
+                 "vmv.v.x v0, %2\n"
+                 "vse8.v v0, (%3)\n"
+                 ".option pop"
+                 : "=&r" (vl) : "r" (n), "r" (c), "r" (d) : "memory");
+  }
+  if(on)
+    intr_on();
+}
+#endif
 
 void*
 memset(void *dst, int c, uint n)
 {
-  char *cdst = (char *) dst;
-  int i;
-  for(i = 0; i < n; i++){
-    cdst[i] = c;
+  uchar *d = dst;
+  uint64 w;
+
+#ifdef RVV
+  if(rvv_enabled && n >= RVV_MIN){
+    rvv_set(d, c, n);
+    return dst;
+  }
+#endif
+  while(n > 0 && ((uint64)d & WMASK)){
+    *d++ = c;
+    n--;
   }
+  if(n >= WSIZE){
+    w = (uchar)c;
+    w |= w << 8;
+    w |= w << 16;
+    w |= w << 32;
+    for(; n >= 4*WSIZE; n -= 4*WSIZE, d += 4*WSIZE){
+      ((word*)d)[0] = w;
+      ((word*)d)[1] = w;
+      ((word*)d)[2] = w;
+      ((word*)d)[3] = w;
+    }
+    for(; n >= WSIZE; n -= WSIZE, d += WSIZE)
+      *(word*)d = w;
+  }
+  while(n-- > 0)
+    *d++ = c;
   return dst;
 }
 
@@ -18,6 +105,15 @@ memcmp(const void *v1, const void *v2, uint n)
 
   s1 = v1;
   s2 = v2;
+  if((((uint64)s1 ^ (uint64)s2) & WMASK) == 0){
+    for(; n > 0 && ((uint64)s1 & WMASK); n--, s1++, s2++)
+      if(*s1 != *s2)
+        return *s1 - *s2;
+    // skip equal words; the byte loop below finds the
+    // differing byte in the first unequal one.
+    for(; n >= WSIZE && *(word*)s1 == *(word*)s2; n -= WSIZE)
+      s1 += WSIZE, s2 += WSIZE;
+  }
   while(n-- > 0){
     if(*s1 != *s2)
       return *s1 - *s2;
@@ -30,8 +126,8 @@ memcmp(const void *v1, const void *v2, uint n)
 void*
 memmove(void *dst, const void *src, uint n)
 {
-  const char *s;
-  char *d;
+  const uchar *s;
+  uchar *d;
 
   if(n == 0)
     return dst;
@@ -39,17 +135,109 @@ memmove(void *dst, const void *src, uint n)
   s = src;
   d = dst;
   if(s < d && s + n > d){
+    // dst overlaps the end of src: copy backwards.
     s += n;
     d += n;
+    if((((uint64)s ^ (uint64)d) & WMASK) == 0){
+      for(; n > 0 && ((uint64)d & WMASK); n--)
+        *--d = *--s;
+      for(; n >= WSIZE; n -= WSIZE){
+        s -= WSIZE;
+        d -= WSIZE;
+        *(word*)d = *(word*)s;
+      }
+    }
     while(n-- > 0)
       *--d = *--s;
-  } else
+  } else {
+#ifdef RVV
+    if(rvv_enabled && n >= RVV_MIN){
+      rvv_copy(d, s, n);
+      return dst;
+    }
+#endif
+    if((((uint64)s ^ (uint64)d) & WMASK) == 0){
+      for(; n > 0 && ((uint64)d & WMASK); n--)
+        *d++ = *s++;
+      for(; n >= 4*WSIZE; n -= 4*WSIZE, s += 4*WSIZE, d += 4*WSIZE){
+        ((word*)d)[0] = ((word*)s)[0];
+        ((word*)d)[1] = ((word*)s)[1];
+        ((word*)d)[2] = ((word*)s)[2];
+        ((word*)d)[3] = ((word*)s)[3];
+      }
+      for(; n >= WSIZE; n -= WSIZE, s += WSIZE, d += WSIZE)
+        *(word*)d = *(word*)s;
+    }
     while(n-- > 0)
       *d++ = *s++;
+  }
 
   return dst;
 }
 
+// copy or zero n bytes, n a multiple of 64, with both pointers
+// 8-byte aligned and not overlapping: no alignment checks and
+// no tail, just 8 words per iteration, loaded before stored.
+static void
+copy64(word *d, const word *s, uint n)
+{
+  for(; n > 0; n -= 64, d += 8, s += 8){
+    uint64 w0 = s[0], w1 = s[1], w2 = s[2], w3 = s[3];
+    uint64 w4 = s[4], w5 = s[5], w6 = s[6], w7 = s[7];
+    d[0] = w0; d[1] = w1; d[2] = w2; d[3] = w3;
+    d[4] = w4; d[5] = w5; d[6] = w6; d[7] = w7;
+  }
+}
+
+static void
+zero64(word *d, uint n)
+{
+  for(; n > 0; n -= 64, d += 8){
+    d[0] = 0; d[1] = 0; d[2] = 0; d[3] = 0;
+    d[4] = 0; d[5] = 0; d[6] = 0; d[7] = 0;
+  }
+}
+
+// copy one page-aligned page to another.
+void
+copy_page(void *dst, const void *src)
+{
+#ifdef RVV
+  if(rvv_enabled){
+    rvv_copy(dst, src, PGSIZE);
+    return;
+  }
+#endif
+  copy64(dst, src, PGSIZE);
+}
+
+// zero one page-aligned page.
+void
+zero_page(void *dst)
+{
+#ifdef RVV
+  if(rvv_enabled){
+    rvv_set(dst, 0, PGSIZE);
+    return;
+  }
+#endif
+  zero64(dst, PGSIZE);
+}
+
+// copy or zero a BSIZE disk block buffer. struct buf's data
+// follows its pointers, so it is 8-byte aligned.
+void
+copy_block(void *dst, const void *src)
+{
+  copy64(dst, src, BSIZE);
+}
+
+void
+zero_block(void *dst)
+{
+  zero64(dst, BSIZE);
+}
+
 // memcpy exists to placate GCC.  Use memmove.
 void*
 memcpy(void *dst, const void *src, uint n)
@@ -0,0 +1,24 @@
+// 批量系统调用描述符，供 syscall_batch(ops, n) 使用。
+//
+// 一次陷入内核执行 n 个系统调用，省去每个调用的
+// usertrap()/prepare_return()/sfence 开销。
+//
+// 参数传递：
+// - 默认 args[i] 原样作为第 i 个参数
+// - argref 的第 i 位置位时，args[i] 表示前面某个 op 的下标，
+//   实际参数取该 op 的返回值（例如 open 的 fd 传给 read/close）
+//
+// 返回值：
+// - ret 中保存内核返回值，失败时是负的错误码（-errno）
+//
+#define MAXBATCH     32        // 每批最多 op 数
+
+#define SOP_STOPERR  (1 << 0)  // 本 op 失败时停止执行后续 op
+
+struct sysop {
+  int num;          // 系统调用号（SYS_xxx）
+  short flags;      // SOP_xxx
+  short argref;     // 位 i 置位：args[i] 引用前面 op 的返回值
+  uint64 args[6];   // 参数 a0-a5
+  long ret;         // 输出：返回值
+};
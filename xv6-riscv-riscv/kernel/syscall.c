@@ -25,6 +25,7 @@
 #include "syscall.h"
 #include "defs.h"
 #include "errno.h"
+#include "sysbatch.h"
 
 
 // fetchaddr - 从用户空间读取一个 uint64 值
@@ -86,7 +87,7 @@ fetchaddr(uint64 addr, uint64 *ip)
 //   -1:   失败（地址非法、无终止符、或超过最大长度）
 //
 // 安全特性：
-//   - copyinstr 会逐字节检查，遇到 '\0' 或达到 max 时停止
+//   - copyinstr 遇到 '\0' 或达到 max 时停止
 //   - 防止缓冲区溢出
 //   - 防止读取内核地址
 //
@@ -100,15 +101,11 @@ fetchstr(uint64 addr, char *buf, int max)
   struct proc *p = myproc();
   
   // copyinstr 会：
-  //   1. 逐字节从用户空间复制
-  //   2. 遇到 '\0' 时停止
-  //   3. 达到 max 字节时停止
-  //   4. 检查每个页面的权限
-  if(copyinstr(p->pagetable, buf, addr, max) < 0)
-    return -1;
-  
-  // 返回字符串长度（不包括 '\0'）
-  return strlen(buf);
+  //   1. 按字（8 字节）从用户空间复制，字内检测 '\0'
+  //   2. 遇到 '\0' 或达到 max 字节时停止
+  //   3. 检查每个页面的权限
+  //   4. 成功时直接返回字符串长度，无需再 strlen 一遍
+  return copyinstr(p->pagetable, buf, addr, max);
 }
 
 
@@ -130,35 +127,15 @@ fetchstr(uint64 addr, char *buf, int max)
 //   - 不进行类型转换和安全检查
 //   - 超过 5 个参数的系统调用需要通过栈传递（xv6 未实现）
 //
-// 设计思想：
-//   - 提供统一的参数访问接口
-//   - 隐藏 trapframe 的内部结构
-//   - 便于移植到其他架构
+// 快速路径：
+//   - trapframe 中 a0-a5 连续存放，直接按下标取值，
+//     省掉 switch 分支和越界 panic
+//   - n 由各 sys_xxx 以常量传入（0-5），不在运行时检查
 //
-static uint64
+static inline uint64
 argraw(int n)
 {
-  struct proc *p = myproc();
-  
-  // 根据参数编号返回对应寄存器的值
-  switch (n) {
-  case 0:
-    return p->trapframe->a0;
-  case 1:
-    return p->trapframe->a1;
-  case 2:
-    return p->trapframe->a2;
-  case 3:
-    return p->trapframe->a3;
-  case 4:
-    return p->trapframe->a4;
-  case 5:
-    return p->trapframe->a5;
-  }
-  
-  // 不应该到达这里（参数编号越界）
-  panic("argraw");
-  return -1;
+  return (&myproc()->trapframe->a0)[n];
 }
 
 
@@ -312,6 +289,19 @@ extern uint64 sys_kill(void);        // 杀死指定进程
 extern uint64 sys_sbrk(void);        // 调整堆大小（支持Lazy分配）
 extern uint64 sys_pause(void);       // 睡眠指定 tick 数
 extern uint64 sys_uptime(void);      // 获取系统运行时间
+extern uint64 sys_clockinfo(void);   // 获取计数器频率（高精度计时）
+extern uint64 sys_trace(void);       // 设置系统调用跟踪掩码
+extern uint64 sys_traceread(void);   // 读出系统调用跟踪记录
+extern uint64 sys_dmesg(void);       // 读出内核日志
+extern uint64 sys_prof(void);        // 设置采样剖析频率
+extern uint64 sys_profread(void);    // 读出采样记录
+extern uint64 sys_faultstat(void);   // 页错误统计
+extern uint64 sys_sysinfo(void);     // 系统统计快照
+extern uint64 sys_tpctl(void);       // 跟踪点开关
+extern uint64 sys_tpread(void);      // 读出跟踪点记录
+extern uint64 sys_perf_stat(void);   // 进程的硬件性能计数
+extern uint64 sys_yield(void);       // 让出 CPU
+uint64 sys_syscall_batch(void);      // 批量系统调用（定义在本文件末尾）
 
 // 文件系统调用
 extern uint64 sys_open(void);        // 打开文件
@@ -331,12 +321,17 @@ extern uint64 sys_link(void);        // 创建硬链接
 extern uint64 sys_mkdir(void);       // 创建目录
 extern uint64 sys_symlink(void);     // 创建符号链接
 extern uint64 sys_readlink(void);    // 读取符号链接
+extern uint64 sys_fdlimit(void);     // 打开文件数上限
 
 // 扩展系统调用
 extern uint64 sys_setpriority(void); // 设置进程优先级
 extern uint64 sys_getpriority(void); // 获取进程优先级
 extern uint64 sys_geterrno(void);    // 获取错误码
 extern uint64 sys_set_scheduler(void); // 设置调度器类型
+extern uint64 sys_setpgid(void);     // 设置进程组
+extern uint64 sys_getpgid(void);     // 获取进程组
+extern uint64 sys_setsid(void);      // 新建会话
+extern uint64 sys_killpg(void);      // 杀死整个进程组
 
 
 // syscalls - 系统调用分发表
@@ -390,10 +385,46 @@ static uint64 (*syscalls[])(void) = {
 [SYS_set_scheduler] sys_set_scheduler, // 25: 设置调度器
 [SYS_symlink] sys_symlink,       // 26: 创建符号链接
 [SYS_readlink] sys_readlink,     // 27: 读取符号链接
+[SYS_clockinfo] sys_clockinfo,   // 28: 计数器频率
+[SYS_syscall_batch] sys_syscall_batch, // 29: 批量系统调用
+[SYS_trace]   sys_trace,         // 30: 跟踪掩码
+[SYS_traceread] sys_traceread,   // 31: 读出跟踪记录
+[SYS_dmesg]   sys_dmesg,         // 32: 读出内核日志
+[SYS_fdlimit] sys_fdlimit,       // 33: 打开文件数上限
+[SYS_setpgid] sys_setpgid,       // 34: 设置进程组
+[SYS_getpgid] sys_getpgid,       // 35: 获取进程组
+[SYS_setsid]  sys_setsid,        // 36: 新建会话
+[SYS_killpg]  sys_killpg,        // 37: 杀死整个进程组
+[SYS_prof]    sys_prof,          // 38: 采样剖析频率
+[SYS_profread] sys_profread,     // 39: 读出采样记录
+[SYS_faultstat] sys_faultstat,   // 40: 页错误统计
+[SYS_sysinfo] sys_sysinfo,       // 41: 系统统计快照
+[SYS_tpctl]   sys_tpctl,         // 42: 跟踪点开关
+[SYS_tpread]  sys_tpread,        // 43: 读出跟踪点记录
+[SYS_perf_stat] sys_perf_stat,   // 44: 进程的硬件性能计数
+[SYS_yield]   sys_yield,         // 45: 让出 CPU
 };
 
 
 
+// traced_call - 执行系统调用并写入跟踪记录（见 trace.c）
+//
+// 参数要在调用前保存：exec 等调用会改写 trapframe
+// 单独成函数并禁止内联，使 syscall() 的常规路径不受影响
+//
+static uint64 __attribute__((noinline))
+traced_call(uint64 (*fn)(void), int num)
+{
+  struct trapframe *tf = myproc()->trapframe;
+  uint64 args[4] = { tf->a0, tf->a1, tf->a2, tf->a3 };
+  uint64 start = r_time();
+  uint64 ret = fn();
+
+  trace_record(num, args, ret, start);
+  return ret;
+}
+
+
 // syscall - 系统调用分发器（支持 errno 机制）
 
 //
@@ -435,23 +466,29 @@ static uint64 (*syscalls[])(void) = {
 void
 syscall(void)
 {
-  int num;               // 系统调用号
+  uint64 num;            // 系统调用号
   uint64 ret;            // 系统调用返回值
+  uint64 (*fn)(void);
   struct proc *p = myproc();
+  struct trapframe *tf = p->trapframe;
 
   // 从 trapframe 的 a7 寄存器获取系统调用号
   // a7 在 usys.S 中被设置：li a7, SYS_xxx
-  num = p->trapframe->a7;
+  num = tf->a7;
   
-  // 验证系统调用号的合法性：
-  //   1. num > 0: 系统调用号从 1 开始
-  //   2. num < NELEM(syscalls): 不能超过数组大小
-  //   3. syscalls[num] != 0: 该系统调用必须已实现
-  if(num > 0 && num < NELEM(syscalls) && syscalls[num]) {
+  // 验证系统调用号的合法性（只做一次无符号比较）：
+  //   1. num < NELEM(syscalls): 负数转成无符号后必然越界
+  //   2. syscalls[num] != 0: 该系统调用必须已实现（也排除了 0 号）
+  fn = num < NELEM(syscalls) ? syscalls[num] : 0;
+  if(fn) {
     
     // 调用对应的系统调用处理函数
     // 例如：num = SYS_fork → 调用 sys_fork()
-    ret = syscalls[num]();
+    // 被跟踪的调用走 traced_call()，未开启跟踪时只多一次掩码测试
+    if(p->tracemask & (1UL << num))
+      ret = traced_call(fn, num);
+    else
+      ret = fn();
     
     // ======== errno 机制处理 ========
     //
@@ -469,7 +506,7 @@ syscall(void)
       
       // 系统调用统一返回 -1 表示失败
       // 用户程序：if (fork() == -1) { check errno }
-      p->trapframe->a0 = -1;
+      tf->a0 = -1;
       
     } else {
       // 成功情况：返回值 >= 0
@@ -478,7 +515,7 @@ syscall(void)
       p->errno = EOK;  // EOK = 0
       
       // 返回实际值（可能是 PID、文件描述符、字节数等）
-      p->trapframe->a0 = ret;
+      tf->a0 = ret;
     }
     
   } else {
@@ -486,14 +523,123 @@ syscall(void)
     
     // 打印错误信息（便于调试）
     printf("%d %s: unknown sys call %d\n",
-            p->pid, p->name, num);
+            p->pid, p->name, (int)num);
     
     // 设置 errno 为 ENOSYS（功能未实现）
     p->errno = ENOSYS;
     
     // 返回 -1
-    p->trapframe->a0 = -1;
+    tf->a0 = -1;
+  }
+}
+
+
+// batch_allowed - 判断系统调用能否在批量模式中执行
+//
+// 不允许的调用：
+//   - fork: 子进程会复制“正在执行批量调用”的 trapframe
+//   - exec: 替换地址空间，后续 op 的描述符已不存在
+//   - exit: 永不返回
+//   - syscall_batch: 禁止嵌套
+//
+static int
+batch_allowed(int num)
+{
+  if(num <= 0 || num >= NELEM(syscalls) || syscalls[num] == 0)
+    return 0;
+  switch(num){
+  case SYS_fork:
+  case SYS_exec:
+  case SYS_exit:
+  case SYS_syscall_batch:
+    return 0;
+  }
+  return 1;
+}
+
+
+// sys_syscall_batch - 在一次陷入中执行一组系统调用
+
+//
+// 用户调用：syscall_batch(ops, n)
+//   ops: struct sysop 数组的用户地址（见 sysbatch.h）
+//   n:   op 个数（1..MAXBATCH）
+//
+// 返回值：
+//   >= 0: 实际执行的 op 个数（遇到 SOP_STOPERR 失败时提前停止）
+//   -EINVAL / -EFAULT: 参数非法
+//
+// 实现：
+//   - 逐个 copyin 描述符（内核栈只有一页，不整批复制）
+//   - 把参数装进 trapframe 的 a0-a5，复用 syscalls[] 分发表，
+//     各 sys_xxx() 的参数提取代码无需任何改动
+//   - 返回值写回 ops[i].ret，并记录下来供后面的 op 通过 argref 引用
+//   - 结束后恢复 trapframe，syscall() 再把返回值写入 a0
+//
+uint64
+sys_syscall_batch(void)
+{
+  uint64 uops, saved[6];
+  int n, i, j;
+  long results[MAXBATCH];
+  struct sysop op;
+  struct proc *p = myproc();
+  struct trapframe *tf = p->trapframe;
+
+  argaddr(0, &uops);
+  argint(1, &n);
+  if(n <= 0 || n > MAXBATCH)
+    return -EINVAL;
+
+  saved[0] = tf->a0; saved[1] = tf->a1; saved[2] = tf->a2;
+  saved[3] = tf->a3; saved[4] = tf->a4; saved[5] = tf->a5;
+
+  for(i = 0; i < n; i++){
+    uint64 uop = uops + i * sizeof(struct sysop);
+
+    if(killed(p))
+      break;
+    if(copyin(p->pagetable, (char *)&op, uop, sizeof(op)) < 0){
+      if(i == 0)
+        i = -EFAULT;
+      break;
+    }
+
+    // 解析参数引用：只能引用已经执行过的 op
+    for(j = 0; j < 6; j++){
+      if(op.argref & (1 << j)){
+        if(op.args[j] >= i){
+          op.ret = -EINVAL;
+          goto done;
+        }
+        op.args[j] = results[op.args[j]];
+      }
+    }
+
+    if(!batch_allowed(op.num)){
+      op.ret = -ENOSYS;
+    } else {
+      tf->a0 = op.args[0]; tf->a1 = op.args[1]; tf->a2 = op.args[2];
+      tf->a3 = op.args[3]; tf->a4 = op.args[4]; tf->a5 = op.args[5];
+      op.ret = syscalls[op.num]();
+    }
+
+  done:
+    results[i] = op.ret;
+    if(copyout(p->pagetable, uop + __builtin_offsetof(struct sysop, ret),
+               (char *)&op.ret, sizeof(op.ret)) < 0){
+      i++;
+      break;
+    }
+    if(op.ret < 0 && (op.flags & SOP_STOPERR)){
+      i++;
+      break;
+    }
   }
+
+  tf->a0 = saved[0]; tf->a1 = saved[1]; tf->a2 = saved[2];
+  tf->a3 = saved[3]; tf->a4 = saved[4]; tf->a5 = saved[5];
+  return i;
 }
 
 
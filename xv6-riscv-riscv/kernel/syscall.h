@@ -26,3 +26,21 @@
 #define SYS_set_scheduler 25
 #define SYS_symlink 26
 #define SYS_readlink 27
+#define SYS_clockinfo 28
+#define SYS_syscall_batch 29
+#define SYS_trace  30
+#define SYS_traceread 31
+#define SYS_dmesg  32
+#define SYS_fdlimit 33
+#define SYS_setpgid 34
+#define SYS_getpgid 35
+#define SYS_setsid 36
+#define SYS_killpg 37
+#define SYS_prof   38
+#define SYS_profread 39
+#define SYS_faultstat 40
+#define SYS_sysinfo 41
+#define SYS_tpctl 42
+#define SYS_tpread 43
+#define SYS_perf_stat 44
+#define SYS_yield 45
@@ -46,7 +46,7 @@ argfd(int n, int *pfd, struct file **pf)
   struct file *f;
 
   argint(n, &fd);
-  if(fd < 0 || fd >= NOFILE || (f=myproc()->ofile[fd]) == 0)
+  if((f = fdlookup(myproc(), fd)) == 0)
     return -1;
   if(pfd)
     *pfd = fd;
@@ -55,22 +55,6 @@ argfd(int n, int *pfd, struct file **pf)
   return 0;
 }
 
-// Allocate a file descriptor for the given file.
-// Takes over file reference from caller on success.
-static int
-fdalloc(struct file *f)
-{
-  int fd;
-  struct proc *p = myproc();
-
-  for(fd = 0; fd < NOFILE; fd++){
-    if(p->ofile[fd] == 0){
-      p->ofile[fd] = f;
-      return fd;
-    }
-  }
-  return -1;
-}
 
 
 // 文件描述符操作
@@ -101,7 +85,7 @@ sys_dup(void)
   if(argfd(0, 0, &f) < 0)  // 获取源文件描述符
     return -1;
   if((fd=fdalloc(f)) < 0)   // 分配新的文件描述符
-    return -1;
+    return fd;              // -EMFILE 或 -ENOMEM
   filedup(f);               // 增加文件引用计数
   return fd;                // 返回新文件描述符
 }
@@ -195,7 +179,7 @@ sys_close(void)
 
   if(argfd(0, &fd, &f) < 0)  // 获取文件描述符
     return -1;
-  myproc()->ofile[fd] = 0;   // 清除进程文件表项
+  fdclear(myproc(), fd);     // 清除进程文件表项
   fileclose(f);              // 关闭文件
   return 0;                  // 成功
 }
@@ -741,13 +725,15 @@ sys_open(void)
   }
 
   // 分配文件描述符
+  // 系统文件表满为 -ENFILE，超出进程上限为 -EMFILE
+  fd = -ENFILE;
   if((f = filealloc()) == 0 || (fd = fdalloc(f)) < 0){
     if(f)
       fileclose(f);
     printf("sys_open: failed to allocate file descriptor for '%s'\n", path);
     iunlockput(ip);
     end_op();
-    return -EMFILE;
+    return fd;
   }
 
   // 设置文件结构
@@ -905,7 +891,7 @@ sys_pipe(void)
 {
   uint64 fdarray; // user pointer to array of two integers
   struct file *rf, *wf;
-  int fd0, fd1;
+  int fd0, fd1, err;
   struct proc *p = myproc();
 
   argaddr(0, &fdarray);
@@ -913,19 +899,39 @@ sys_pipe(void)
     return -1;
   fd0 = -1;
   if((fd0 = fdalloc(rf)) < 0 || (fd1 = fdalloc(wf)) < 0){
+    err = fd0 < 0 ? fd0 : fd1;  // -EMFILE 或 -ENOMEM，同 sys_dup
     if(fd0 >= 0)
-      p->ofile[fd0] = 0;
+      fdclear(p, fd0);
     fileclose(rf);
     fileclose(wf);
-    return -1;
+    return err;
   }
   if(copyout(p->pagetable, fdarray, (char*)&fd0, sizeof(fd0)) < 0 ||
      copyout(p->pagetable, fdarray+sizeof(fd0), (char *)&fd1, sizeof(fd1)) < 0){
-    p->ofile[fd0] = 0;
-    p->ofile[fd1] = 0;
+    fdclear(p, fd0);
+    fdclear(p, fd1);
     fileclose(rf);
     fileclose(wf);
     return -1;
   }
   return 0;
 }
+
+// sys_fdlimit - 查询或设置本进程的打开文件数上限
+//
+// 用户调用：fdlimit(n)
+// - n > 0:  把上限设为 n（最大 NFDPAGE*504），fork 出的子进程继承
+// - n == 0: 只查询
+//
+// 调低上限不会关闭已经打开的 fd，只影响之后的分配
+//
+// 返回值：原来的上限，或 -EINVAL
+//
+uint64
+sys_fdlimit(void)
+{
+  int n;
+
+  argint(0, &n);
+  return fdsetlimit(myproc(), n);
+}
@@ -0,0 +1,100 @@
+// kernel/sysinfo.c - 统一的系统统计快照
+
+//
+// 功能：
+// - 把分散在各模块中的计数汇总成一个 struct sysinfo
+//   （见 sysinfo.h），通过 sysinfo() 系统调用一次读出
+// - 内存、块缓存、日志、磁盘的计数由各模块自己维护，
+//   在各自的锁下更新，这里调用 kmemstat/bstat/logstat/diskstat 取出
+// - 调度、系统调用、中断、自旋锁的计数放在 struct cpu 中，
+//   只由本 CPU 关中断更新，读出时求和
+//
+// 开销：
+// - 读一次快照是 NCPU 次求和、几次短暂的加锁和一次 allproc 遍历，
+//   每秒轮询一次的代价可以忽略
+// - 快照不是原子的，各项之间可能有少量不一致
+//
+// 版本：
+// - 用户传入自己的结构大小，内核复制两者中较小的部分并返回
+//   内核的大小，字段只在末尾追加（见 sysinfo.h）
+//
+
+#include "types.h"
+#include "param.h"
+#include "memlayout.h"
+#include "riscv.h"
+#include "spinlock.h"
+#include "proc.h"
+#include "defs.h"
+#include "errno.h"
+#include "sysinfo.h"
+
+extern struct proc *allproc;
+
+// 汇总各 CPU 的计数
+static void
+cpustat(struct sysinfo *si)
+{
+  struct cpu *c;
+
+  for(c = cpus; c < &cpus[NCPU]; c++){
+    si->ctxswitches += c->nswitch;
+    si->syscalls += c->nsyscall;
+    si->interrupts += c->nintr;
+    si->lock_acquires += c->nacquire;
+    si->lock_contended += c->ncontend;
+    si->lock_spins += c->nspin;
+  }
+}
+
+// 统计进程数；proc 结构体从不释放，可以不加锁遍历
+static void
+procstat(struct sysinfo *si)
+{
+  struct proc *p;
+
+  for(p = allproc; p != 0; p = p->allnext){
+    if(p->state == UNUSED)
+      continue;
+    si->nproc++;
+    if(p->state == RUNNABLE)
+      si->nrunnable++;
+  }
+}
+
+// sysinfo - 把统计快照复制到用户空间
+//
+// 参数：
+//   addr: 用户空间的 struct sysinfo
+//   size: 用户结构的大小，只复制前 min(size, sizeof) 字节
+//
+// 返回值：内核的 sizeof(struct sysinfo)，或 -EFAULT
+//
+int
+sysinfo(uint64 addr, int size)
+{
+  struct sysinfo si;
+  struct proc *p = myproc();
+
+  memset(&si, 0, sizeof(si));
+  si.version = SYSINFO_VERSION;
+  si.size = sizeof(si);
+
+  acquire(&tickslock);
+  si.ticks = ticks;
+  release(&tickslock);
+
+  kmemstat(&si);
+  procstat(&si);
+  cpustat(&si);
+  si.faults = faulttotal();
+  bstat(&si);
+  logstat(&si);
+  diskstat(&si);
+
+  if(size > sizeof(si))
+    size = sizeof(si);
+  if(copyout(p->pagetable, addr, (char *)&si, size) < 0)
+    return -EFAULT;
+  return sizeof(si);
+}
@@ -0,0 +1,48 @@
+// 系统统计快照，内核 sysinfo.c 汇总，用户态 sysinfo() 读出。
+//
+// 结构只在末尾追加字段，追加时不改变已有字段的偏移；
+// 改变已有字段的含义或布局时 SYSINFO_VERSION 加 1。
+// 内核按 min(用户给的大小, sizeof) 复制并返回 sizeof，
+// 旧程序读新内核、新程序读旧内核都能得到各自认识的前缀。
+//
+// 所有计数从启动开始单调增加（mem_*、nproc、nrunnable 除外），
+// 轮询工具取两次快照之差即可得到速率。
+//
+#define SYSINFO_VERSION 1
+
+struct sysinfo {
+  uint version;            // SYSINFO_VERSION
+  uint size;               // 内核的 sizeof(struct sysinfo)
+  uint64 ticks;            // 启动以来的时钟 tick 数
+
+  // 物理内存，单位：页
+  uint64 mem_total;        // 交给分配器的页数
+  uint64 mem_free;         // 空闲页数
+  uint64 mem_shared;       // 被多个页表共享（COW）的页数
+
+  // 进程与调度
+  uint64 nproc;            // 已分配的进程数（含僵尸）
+  uint64 nrunnable;        // 就绪等待 CPU 的进程数
+  uint64 ctxswitches;      // 调度器切换到进程的次数
+  uint64 syscalls;         // 用户态 ecall 次数
+  uint64 interrupts;       // 设备和时钟中断次数
+  uint64 faults;           // 用户页错误次数（见 faultstat.h）
+
+  // 块缓存
+  uint64 bcache_hits;
+  uint64 bcache_misses;
+
+  // 日志
+  uint64 log_commits;      // 写入磁盘的事务数
+  uint64 log_blocks;       // 经日志写入的块数
+  uint64 log_waits;        // begin_op 因日志忙或空间不足而睡眠的次数
+
+  // 磁盘
+  uint64 disk_reads;
+  uint64 disk_writes;
+
+  // 自旋锁
+  uint64 lock_acquires;    // acquire 次数
+  uint64 lock_contended;   // 第一次没抢到锁的 acquire 次数
+  uint64 lock_spins;       // 等锁时的重试次数
+};
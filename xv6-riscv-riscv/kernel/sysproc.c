@@ -32,9 +32,7 @@
 #include "proc.h"
 #include "vm.h"
 #include "errno.h"
-
-// 外部变量声明
-extern struct proc proc[NPROC];
+#include "clock.h"
 
 
 // sys_exit - exit 系统调用的包装函数
@@ -339,6 +337,24 @@ sys_pause(void)
 }
 
 
+// sys_yield - 让出 CPU
+//
+// 用户调用：yield()
+//
+// 当前进程变为 RUNNABLE 并切换到调度器，由调度策略决定下一个
+// 运行的进程；没有其他就绪进程时立即重新选中自己。
+// 用于测量一次调度往返的开销（见 user/microbench.c）
+//
+// 返回值：0
+//
+uint64
+sys_yield(void)
+{
+  yield();
+  return 0;
+}
+
+
 // sys_kill - kill 系统调用的包装函数
 
 //
@@ -387,6 +403,68 @@ sys_kill(void)
 }
 
 
+// sys_killpg - 杀死整个进程组
+//
+// 用户调用：killpg(pgid)
+// - pgid: 目标进程组，0 表示自己所在的组
+//
+// 一次调用拆除整个作业，代价与组内进程数成正比
+//
+// 返回值：0，或 -ESRCH / -EINVAL
+//
+uint64
+sys_killpg(void)
+{
+  int pgid;
+
+  argint(0, &pgid);
+  return kkillpg(pgid);
+}
+
+// sys_setpgid - 把自己或子进程移到某个进程组
+//
+// 用户调用：setpgid(pid, pgid)
+// - pid: 0 表示自己
+// - pgid: 0 表示以 pid 为组号新建进程组
+//
+// 返回值：0，或 -ESRCH / -EPERM / -EINVAL
+//
+uint64
+sys_setpgid(void)
+{
+  int pid, pgid;
+
+  argint(0, &pid);
+  argint(1, &pgid);
+  return ksetpgid(pid, pgid);
+}
+
+// sys_getpgid - 获取进程的进程组号
+//
+// 用户调用：getpgid(pid)，pid 为 0 表示自己
+//
+uint64
+sys_getpgid(void)
+{
+  int pid;
+
+  argint(0, &pid);
+  return kgetpgid(pid);
+}
+
+// sys_setsid - 新建会话，调用者成为会话首进程和组长
+//
+// 用户调用：setsid()
+//
+// 返回值：新会话号，或 -EPERM（调用者已是组长）
+//
+uint64
+sys_setsid(void)
+{
+  return ksetsid();
+}
+
+
 // sys_uptime - uptime 系统调用的包装函数
 //
 // 功能：获取系统启动以来的时钟滴答数
@@ -433,6 +511,261 @@ sys_uptime(void)
 }
 
 
+// sys_clockinfo - 返回 time/cycle 计数器的频率
+//
+// 功能：配合用户态 rdtime/rdcycle 实现高精度计时
+//
+// 用户调用：clockinfo(&ci)
+// - ci: struct clockinfo 的用户空间地址
+//
+// 返回值：
+// - 0: 成功
+// - -EFAULT: 地址非法
+//
+// 为什么不直接提供 "读时间" 系统调用？
+// - uptime() 只有 tick 精度（约 100ms），测不出短操作
+// - 每次陷入内核本身就要几百个周期，会污染测量结果
+// - 计数器在 trapinithart() 中已对用户态开放，只需告诉用户换算比例
+//
+// 用户库 clock_gettime() 第一次调用时取一次频率并缓存
+//
+uint64
+sys_clockinfo(void)
+{
+  uint64 addr;
+  struct clockinfo ci;
+
+  argaddr(0, &addr);
+  ci.time_freq = TIMEBASE_FREQ;
+  ci.cycle_freq = cycle_freq;
+  if(copyout(myproc()->pagetable, addr, (char *)&ci, sizeof(ci)) < 0)
+    return -EFAULT;
+  return 0;
+}
+
+
+// sys_trace - 设置当前进程的系统调用跟踪掩码
+//
+// 用户调用：trace(mask)
+// - mask: 位 (1 << SYS_xxx) 置位表示跟踪该调用，0 关闭跟踪
+//
+// 掩码会被 fork 出的子进程继承，exec 后保留，
+// 因此 strace 只需在子进程中设置一次再 exec 目标程序
+//
+// 返回值：0
+//
+uint64
+sys_trace(void)
+{
+  uint64 mask;
+
+  argaddr(0, &mask);
+  myproc()->tracemask = mask;
+  return 0;
+}
+
+
+// sys_traceread - 读出各 CPU 跟踪环中的记录
+//
+// 用户调用：traceread(buf, n, &lost)
+// - buf:  struct traceent 数组
+// - n:    数组容量
+// - lost: 可为 0；否则写入自上次读出以来被覆盖丢失的记录数
+//
+// 返回值：复制的记录数，或 -EBUSY / -EFAULT / -EINVAL
+//
+uint64
+sys_traceread(void)
+{
+  uint64 buf, lost;
+  int n;
+
+  argaddr(0, &buf);
+  argint(1, &n);
+  argaddr(2, &lost);
+  if(n < 0)
+    return -EINVAL;
+  return traceread(buf, n, lost);
+}
+
+
+// sys_prof - 设置采样剖析频率
+//
+// 用户调用：prof(hz)
+// - hz: 每个 CPU 每秒的采样数（最多 PROF_MAXHZ），0 关闭采样，负数只查询
+//
+// 采样是全系统的：所有 CPU 上的内核和用户代码都会被采样
+//
+// 返回值：原来的频率，或 -EINVAL
+//
+uint64
+sys_prof(void)
+{
+  int hz;
+
+  argint(0, &hz);
+  return profset(hz);
+}
+
+
+// sys_profread - 读出各 CPU 采样环中的记录
+//
+// 用户调用：profread(buf, n, &lost)
+// - buf:  struct profent 数组
+// - n:    数组容量
+// - lost: 可为 0；否则写入自上次读出以来被覆盖丢失的记录数
+//
+// 返回值：复制的记录数，或 -EBUSY / -EFAULT / -EINVAL
+//
+uint64
+sys_profread(void)
+{
+  uint64 buf, lost;
+  int n;
+
+  argaddr(0, &buf);
+  argint(1, &n);
+  argaddr(2, &lost);
+  if(n < 0)
+    return -EINVAL;
+  return profread(buf, n, lost);
+}
+
+
+// sys_faultstat - 读出页错误统计
+//
+// 用户调用：faultstat(pid, &st)
+// - pid: FAULTSTAT_ALL (-1) 全局，FAULTSTAT_SELF (0) 当前进程，
+//        其他值为指定进程
+// - st:  struct faultstat 的用户空间地址
+//
+// 返回值：0，或 -ESRCH / -EFAULT
+//
+uint64
+sys_faultstat(void)
+{
+  uint64 addr;
+  int pid;
+
+  argint(0, &pid);
+  argaddr(1, &addr);
+  return faultstat(pid, addr);
+}
+
+
+// sys_sysinfo - 读出系统统计快照
+//
+// 用户调用：sysinfo(&si, sizeof(si))
+// - si:   struct sysinfo 的用户空间地址
+// - size: 调用者的结构大小，内核只复制不超过它的部分
+//
+// 返回值：内核的 sizeof(struct sysinfo)，或 -EFAULT / -EINVAL
+//
+uint64
+sys_sysinfo(void)
+{
+  uint64 addr;
+  int size;
+
+  argaddr(0, &addr);
+  argint(1, &size);
+  if(size < 0)
+    return -EINVAL;
+  return sysinfo(addr, size);
+}
+
+
+// sys_tpctl - 打开或关闭静态跟踪点
+//
+// 用户调用：tpctl(mask)
+// - mask: 位 (1 << TP_xxx)，0 全部关闭，负数只查询
+//
+// 跟踪点是全系统的：所有进程和内核线程的事件都会被记录
+//
+// 返回值：原来的掩码，或 -EINVAL
+//
+uint64
+sys_tpctl(void)
+{
+  int mask;
+
+  argint(0, &mask);
+  return tpctl(mask);
+}
+
+
+// sys_tpread - 读出各 CPU 跟踪点环中的记录
+//
+// 用户调用：tpread(buf, n, &lost)
+// - buf:  struct tpent 数组
+// - n:    数组容量
+// - lost: 可为 0；否则写入自上次读出以来被覆盖丢失的记录数
+//
+// 返回值：复制的记录数，或 -EBUSY / -EFAULT / -EINVAL
+//
+uint64
+sys_tpread(void)
+{
+  uint64 buf, lost;
+  int n;
+
+  argaddr(0, &buf);
+  argint(1, &n);
+  argaddr(2, &lost);
+  if(n < 0)
+    return -EINVAL;
+  return tpread(buf, n, lost);
+}
+
+
+// sys_perf_stat - 读出进程的硬件性能计数
+//
+// 用户调用：perf_stat(pid, &st)
+// - pid: PERF_SELF (0) 当前进程，PERF_CHILDREN (-1) 已回收的子孙之和，
+//        其他值为指定进程
+// - st:  struct perfstat 的用户空间地址
+//
+// 返回值：0，或 -ESRCH / -EFAULT
+//
+uint64
+sys_perf_stat(void)
+{
+  uint64 addr;
+  int pid;
+
+  argint(0, &pid);
+  argaddr(1, &addr);
+  return perfstat(pid, addr);
+}
+
+
+// sys_dmesg - 读出各 CPU 内核日志环中仍保留的记录
+//
+// 用户调用：dmesg(buf, n)
+// - buf: struct klogent 数组
+// - n:   数组容量
+//
+// 不消耗记录，控制台输出不受影响；每个 CPU 最多保留
+// KLOG_NENT 条，更早的已被覆盖
+//
+// 返回值：复制的记录数，或 -EFAULT / -EINVAL
+//
+uint64
+sys_dmesg(void)
+{
+  uint64 buf;
+  int n, cnt;
+
+  argaddr(0, &buf);
+  argint(1, &n);
+  if(n < 0)
+    return -EINVAL;
+  if((cnt = klog_read(buf, n)) < 0)
+    return -EFAULT;
+  return cnt;
+}
+
+
 // 系统调用总结
 
 //
@@ -522,18 +855,12 @@ sys_setpriority(void)
     return 0;
   }
   
-  // 查找指定 PID 的进程
-  for(p = proc; p < &proc[NPROC]; p++) {
-    acquire(&p->lock);
-    if(p->pid == pid) {
-      p->priority = priority;
-      release(&p->lock);
-      return 0;
-    }
-    release(&p->lock);
-  }
-  
-  return -ESRCH;  // 进程不存在 (No such process)
+  // 通过 pid 哈希表查找指定 PID 的进程（找到时持有 p->lock）
+  if((p = findproc(pid)) == 0)
+    return -ESRCH;  // 进程不存在 (No such process)
+  p->priority = priority;
+  release(&p->lock);
+  return 0;
 }
 
 
@@ -571,18 +898,12 @@ sys_getpriority(void)
     return priority;
   }
   
-  // 查找指定 PID 的进程
-  for(p = proc; p < &proc[NPROC]; p++) {
-    acquire(&p->lock);
-    if(p->pid == pid) {
-      priority = p->priority;
-      release(&p->lock);
-      return priority;
-    }
-    release(&p->lock);
-  }
-  
-  return -ESRCH;  // 进程不存在 (No such process)
+  // 通过 pid 哈希表查找指定 PID 的进程（找到时持有 p->lock）
+  if((p = findproc(pid)) == 0)
+    return -ESRCH;  // 进程不存在 (No such process)
+  priority = p->priority;
+  release(&p->lock);
+  return priority;
 }
 
 
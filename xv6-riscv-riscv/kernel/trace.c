@@ -0,0 +1,66 @@
+
+// kernel/trace.c - 系统调用跟踪环形缓冲区
+
+//
+// 功能：
+// - 记录被跟踪进程的每次系统调用：号、pid、参数、返回值、耗时
+// - 通过 trace(mask) 按进程开启，fork 出的子进程继承掩码
+// - 用户程序通过 traceread() 取走记录（见 user/strace.c）
+//
+// 记录存放在每 CPU 无锁环中（见 ring.c）
+//
+// 开销：
+// - 未开启跟踪时，syscall() 只多一次掩码测试
+//
+
+#include "types.h"
+#include "param.h"
+#include "memlayout.h"
+#include "riscv.h"
+#include "spinlock.h"
+#include "proc.h"
+#include "defs.h"
+#include "trace.h"
+#include "ring.h"
+
+static struct traceent traceents[NCPU][TRACE_NENT] __attribute__((aligned(64)));
+static struct ring tracering = RING_INIT(traceents);
+
+
+// trace_record - 记录一次系统调用（由 syscall() 调用）
+//
+// 参数：
+//   num:   系统调用号
+//   args:  调用前保存的 a0-a3
+//   ret:   系统调用返回值
+//   start: 进入时的 r_time()
+//
+void
+trace_record(int num, uint64 *args, uint64 ret, uint64 start)
+{
+  struct traceent *e;
+
+  e = ring_reserve(&tracering);
+  e->start = start;
+  e->dur = r_time() - start;
+  e->args[0] = args[0];
+  e->args[1] = args[1];
+  e->args[2] = args[2];
+  e->args[3] = args[3];
+  e->ret = ret;
+  e->pid = myproc()->pid;
+  e->num = num;
+  e->cpu = cpuid();
+  ring_publish(&tracering);
+}
+
+
+// traceread - 把所有 CPU 环中的记录复制到用户空间
+//
+// 参数和返回值见 ring_read（ubuf 是 struct traceent 数组）
+//
+int
+traceread(uint64 ubuf, int n, uint64 ulost)
+{
+  return ring_read(&tracering, ubuf, n, ulost);
+}
@@ -0,0 +1,20 @@
+// 系统调用跟踪记录，内核 trace.c 写入，用户态 traceread() 读出。
+//
+// 每个 CPU 一个环形缓冲区，只由本 CPU 在 syscall() 中写入，
+// 写满后覆盖最旧的记录；读者发现被覆盖的记录时计入 lost。
+//
+// 时间单位是 time 计数器的 tick（频率见 clockinfo()）。
+//
+#define TRACE_NENT   512       // 每个 CPU 的环形缓冲区记录数（2 的幂）
+
+#define TRACE_ALL    (~0UL)    // trace() 掩码：跟踪所有系统调用
+
+struct traceent {
+  uint64 start;     // 进入系统调用时的 r_time()
+  uint64 dur;       // 耗时（time tick）
+  uint64 args[4];   // 参数 a0-a3
+  long ret;         // 返回值，失败时是负的错误码（-errno）
+  int pid;          // 调用进程
+  short num;        // 系统调用号（SYS_xxx）
+  short cpu;        // 执行的 CPU
+};
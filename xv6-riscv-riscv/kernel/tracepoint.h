@@ -0,0 +1,39 @@
+// 静态跟踪点记录，内核 tracepoint.c 写入，用户态 tpread() 读出。
+//
+// 跟踪点编译在内核的关键路径上（调度、唤醒、页分配、块缓存、
+// 日志、磁盘、页错误），每个事件一个开关位，由 tpctl(mask) 设置；
+// 关闭时每个跟踪点只多一次掩码测试。
+//
+// 每个 CPU 一个环形缓冲区，写满后覆盖最旧的记录。
+// 时间单位是 time 计数器的 tick（频率见 clockinfo()），
+// 各 CPU 的 time 计数器是同步的，不同 CPU 的记录可以直接比较先后。
+//
+#define TP_NENT   1024          // 每个 CPU 的环形缓冲区记录数（2 的幂）
+
+//                                 arg[0]        arg[1]
+#define TP_SCHED_IN       0     // -             -          调度器切换到进程
+#define TP_SCHED_OUT      1     // 新状态        -          进程切回调度器
+#define TP_WAKEUP         2     // 被唤醒的 pid  chan
+#define TP_KALLOC         3     // 物理地址      -
+#define TP_KFREE          4     // 物理地址      -
+#define TP_BGET_HIT       5     // 块号          dev
+#define TP_BGET_MISS      6     // 块号          dev
+#define TP_BEGIN_OP       7     // -             -          进入 begin_op
+#define TP_BEGIN_OP_DONE  8     // 等待次数      -          begin_op 返回
+#define TP_COMMIT         9     // 块数          -          开始提交
+#define TP_COMMIT_DONE    10    // 块数          -          提交完成
+#define TP_DISK_SUBMIT    11    // 块号          是否写
+#define TP_DISK_DONE      12    // 块号          -          中断中完成
+#define TP_FAULT          13    // 虚拟地址      FAULT_xxx  用户页错误
+#define TP_NEVENT         14
+
+#define TP_ALL    ((1 << TP_NEVENT) - 1)   // tpctl() 掩码：全部事件
+
+struct tpent {
+  uint64 time;      // r_time()
+  uint64 arg[2];    // 含义见上表
+  int pid;          // 当前进程，调度器中为 0
+  uchar ev;         // TP_xxx
+  uchar cpu;        // 记录的 CPU
+  ushort pad;
+};
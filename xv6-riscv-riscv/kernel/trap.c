@@ -8,6 +8,7 @@
 
 struct spinlock tickslock;
 uint ticks;
+uint64 cycle_freq;   // cycle CSR ticks per second, set by clockcalibrate()
 
 extern char trampoline[], uservec[];
 
@@ -22,11 +23,33 @@ trapinit(void)
   initlock(&tickslock, "time");
 }
 
+// measure the cycle counter's frequency against the
+// time CSR, whose rate is fixed by the platform.
+// spins for about 10ms; called once at boot.
+void
+clockcalibrate(void)
+{
+  uint64 t0, t1, c0, c1;
+
+  t0 = r_time();
+  c0 = r_cycle();
+  while((t1 = r_time()) - t0 < TIMEBASE_FREQ / 100)
+    ;
+  c1 = r_cycle();
+  cycle_freq = (c1 - c0) * TIMEBASE_FREQ / (t1 - t0);
+}
+
 // set up to take exceptions and traps while in the kernel.
 void
 trapinithart(void)
 {
   w_stvec((uint64)kernelvec);
+
+  // let user code read time/cycle/instret and the
+  // hpmcounters directly (rdtime, rdcycle, rdinstret,
+  // csrr hpmcounterN) without a system call.
+  w_scounteren(COUNTEREN_CY | COUNTEREN_TM | COUNTEREN_IR |
+               COUNTEREN_HPM(3) | COUNTEREN_HPM(4) | COUNTEREN_HPM(5));
 }
 
 //
@@ -60,6 +83,7 @@ usertrap(void)
     // sepc points to the ecall instruction,
     // but we want to return to the next instruction.
     p->trapframe->epc += 4;
+    mycpu()->nsyscall++;
 
     // an interrupt will change sepc, scause, and sstatus,
     // so enable only now that we're done with those registers.
@@ -69,30 +93,31 @@ usertrap(void)
   } else if((which_dev = devintr()) != 0){
     // ok
   } else if(r_scause() == 15) {
-    // Store/AMO page fault - try COW handler first
+    // Store/AMO page fault: COW, lazy allocation, or spurious.
     uint64 va = r_stval();
-    if(cowhandler(p->pagetable, va) == 0) {
-      // COW handled successfully
-    } else if(vmfault(p->pagetable, va, 0) != 0) {
-      // Lazy allocation handled
-    } else {
+    if(uvmfault(p->pagetable, va, 1) < 0) {
       // Real page fault
       printf("usertrap(): store page fault va=0x%lx pid=%d\n", va, p->pid);
       setkilled(p);
     }
-  } else if(r_scause() == 13 && vmfault(p->pagetable, r_stval(), 1) != 0) {
-    // Load page fault on lazily-allocated page
+  } else if(r_scause() == 13 && uvmfault(p->pagetable, r_stval(), 0) == 0) {
+    // Load page fault on lazily-allocated page, or spurious
   } else {
     printf("usertrap(): unexpected scause 0x%lx pid=%d\n", r_scause(), p->pid);
     printf("            sepc=0x%lx stval=0x%lx\n", r_sepc(), r_stval());
     setkilled(p);
   }
 
+  // take a profiling sample on any timer interrupt.
+  if(which_dev >= 2)
+    profintr(p->trapframe->epc, p->trapframe->s0, p->trapframe->ra, 1);
+
   if(killed(p))
     kexit(-1);
 
-  // give up the CPU if this is a timer interrupt.
-  if(which_dev == 2)
+  // give up the CPU if this is a timer interrupt, the
+  // time slice is used up, and someone else can run.
+  if(which_dev == 2 && schedtick())
     yield();
 
   prepare_return();
@@ -162,8 +187,16 @@ kerneltrap()
     panic("kerneltrap");
   }
 
-  // give up the CPU if this is a timer interrupt.
-  if(which_dev == 2 && myproc() != 0)
+  // take a profiling sample on any timer interrupt. kernelvec
+  // doesn't touch s0, so our caller's saved fp is the interrupted
+  // code's s0; kernelvec saved ra at the bottom of its frame,
+  // which is where our frame starts.
+  if(which_dev >= 2)
+    profintr(sepc, *(uint64*)(r_fp() - 16), *(uint64*)r_fp(), 0);
+
+  // give up the CPU if this is a timer interrupt, the
+  // time slice is used up, and someone else can run.
+  if(which_dev == 2 && myproc() != 0 && schedtick())
     yield();
 
   // the yield() may have caused some traps to occur,
@@ -172,63 +205,40 @@ kerneltrap()
   w_sstatus(sstatus);
 }
 
-void
+// returns 1 if a clock tick elapsed, 0 if this was only
+// a profiling interrupt between ticks (see prof.c).
+int
 clockintr()
 {
+  struct cpu *c = mycpu();
+
+  if(r_time() < c->nexttick){
+    w_stimecmp(profnext(c->nexttick));
+    return 0;
+  }
+  // ask for the next tick about a tenth of a second from now.
+  c->nexttick = r_time() + 1000000;
+
   if(cpuid() == 0){
     acquire(&tickslock);
     ticks++;
     wakeup(&ticks);
     release(&tickslock);
-  }
-  
-  // MLFQ 调度器：跟踪时间片使用和降级
-  struct proc *p = myproc();
-  if(p) {
-    extern struct proc* (*select_next_proc)(void);
-    extern struct proc* mlfq_scheduler(void);
-    
-    if(select_next_proc == mlfq_scheduler) {
-      acquire(&p->lock);
-      
-      // 增加时间片使用计数
-      p->time_used++;
-      
-      // 检查是否用完时间片
-      if(p->time_used >= p->time_quantum) {
-        // 用完时间片，需要降级
-        if(p->mlfq_level < 4) {  // MAX_PRIORITY_LEVELS - 1
-          // 从当前队列移除
-          mlfq_remove_process(p, p->mlfq_level);
-          
-          // 降级到下一级
-          p->mlfq_level++;
-          p->time_quantum = 1 << p->mlfq_level;  // 新的时间片
-          p->time_used = 0;                       // 重置计数
-          
-          // 如果进程仍是 RUNNABLE，加入新队列
-          if(p->state == RUNNABLE) {
-            mlfq_add_process(p, p->mlfq_level);
-          }
-        } else {
-          // 已经在最低级，重置时间片
-          p->time_used = 0;
-        }
-      }
-      
-      release(&p->lock);
-    }
+
+    // send kernel log text printed while locks were held.
+    uartkick();
   }
 
-  // ask for the next timer interrupt. this also clears
-  // the interrupt request. 1000000 is about a tenth
-  // of a second.
-  w_stimecmp(r_time() + 1000000);
+  // ask for the next timer interrupt, or an earlier one
+  // if profiling. this also clears the interrupt request.
+  w_stimecmp(profnext(c->nexttick));
+  return 1;
 }
 
 // check if it's an external interrupt or software interrupt,
 // and handle it.
-// returns 2 if timer interrupt,
+// returns 2 if timer tick,
+// 3 if a profiling-only timer interrupt,
 // 1 if other device,
 // 0 if not recognized.
 int
@@ -236,6 +246,9 @@ devintr()
 {
   uint64 scause = r_scause();
 
+  if(scause == 0x8000000000000009L || scause == 0x8000000000000005L)
+    mycpu()->nintr++;
+
   if(scause == 0x8000000000000009L){
     // this is a supervisor external interrupt, via PLIC.
 
@@ -259,8 +272,7 @@ devintr()
     return 1;
   } else if(scause == 0x8000000000000005L){
     // timer interrupt.
-    clockintr();
-    return 2;
+    return clockintr() ? 2 : 3;
   } else {
     return 0;
   }
@@ -34,14 +34,23 @@
 #define LSR 5                 // line status register
 #define LSR_RX_READY (1<<0)   // input is waiting to be read from RHR
 #define LSR_TX_IDLE (1<<5)    // THR can accept another character to send
+#define UART_FIFO_SIZE 16     // bytes the transmit FIFO holds once THR is empty
 
 #define ReadReg(reg) (*(Reg(reg)))
 #define WriteReg(reg, v) (*(Reg(reg)) = (v))
 
-// for transmission.
+// the transmit output buffer.
+// writers append at tx_w and sleep only when it is full;
+// uartstart() tops it up with kernel log text (klog.c) and
+// moves up to a FIFO's worth of bytes at a time from tx_r
+// into the UART.
 static struct spinlock tx_lock;
-static int tx_busy;           // is the UART busy sending?
-static int tx_chan;           // &tx_chan is the "wait channel"
+#define UART_TX_BUF_SIZE 256
+static char tx_buf[UART_TX_BUF_SIZE];
+static uint64 tx_w;           // write next to tx_buf[tx_w % UART_TX_BUF_SIZE]
+static uint64 tx_r;           // read next from tx_buf[tx_r % UART_TX_BUF_SIZE]
+
+static void uartstart(void);
 
 extern volatile int panicking; // from printf.c
 extern volatile int panicked; // from printf.c
@@ -74,31 +83,35 @@ uartinit(void)
   initlock(&tx_lock, "uart");
 }
 
-// transmit buf[] to the uart. it blocks if the
-// uart is busy, so it cannot be called from
-// interrupts, only from write() system calls.
+// append buf[] to the output buffer and start the UART
+// if it is idle. it blocks only if the buffer is full,
+// so it cannot be called from interrupts, only from
+// write() system calls.
 void
 uartwrite(char buf[], int n)
 {
   acquire(&tx_lock);
 
+  if(panicked){
+    for(;;)
+      ;
+  }
+
   int i = 0;
-  while(i < n){ 
-    while(tx_busy != 0){
-      // wait for a UART transmit-complete interrupt
-      // to set tx_busy to 0.
-      sleep(&tx_chan, &tx_lock);
-    }   
-      
-    WriteReg(THR, buf[i]);
-    i += 1;
-    tx_busy = 1;
+  while(i < n){
+    while(tx_w == tx_r + UART_TX_BUF_SIZE){
+      // buffer is full.
+      // wait for uartstart() to open up space in the buffer.
+      sleep(&tx_r, &tx_lock);
+    }
+    while(i < n && tx_w < tx_r + UART_TX_BUF_SIZE)
+      tx_buf[tx_w++ % UART_TX_BUF_SIZE] = buf[i++];
+    uartstart();
   }
 
   release(&tx_lock);
 }
 
-
 // write a byte to the uart without using
 // interrupts, for use by kernel printf() and
 // to echo characters. it spins waiting for the uart's
@@ -123,6 +136,101 @@ uartputc_sync(int c)
     pop_off();
 }
 
+// move pending kernel log text into free space in the
+// transmit buffer. caller must hold tx_lock.
+static void
+uartfill(void)
+{
+  while(tx_w < tx_r + UART_TX_BUF_SIZE){
+    int off = tx_w % UART_TX_BUF_SIZE;
+    int n = UART_TX_BUF_SIZE - off;
+    if(n > tx_r + UART_TX_BUF_SIZE - tx_w)
+      n = tx_r + UART_TX_BUF_SIZE - tx_w;
+    int got = klog_console(&tx_buf[off], n);
+    tx_w += got;
+    if(got < n)
+      break;
+  }
+}
+
+// if the UART is idle, and characters are waiting in the
+// transmit buffer, send up to a FIFO's worth of them.
+// caller must hold tx_lock.
+// called from both the top- and bottom-half.
+static void
+uartstart(void)
+{
+  if(panicked)
+    return;
+
+  uartfill();
+
+  // LSR_TX_IDLE means the whole transmit FIFO is empty,
+  // so it can take UART_FIFO_SIZE bytes without another check.
+  if(tx_w == tx_r || (ReadReg(LSR) & LSR_TX_IDLE) == 0)
+    return;
+
+  for(int k = 0; k < UART_FIFO_SIZE && tx_r != tx_w; k++)
+    WriteReg(THR, tx_buf[tx_r++ % UART_TX_BUF_SIZE]);
+
+  // maybe uartwrite() is waiting for space in the buffer.
+  wakeup(&tx_r);
+}
+
+// start sending newly logged kernel text if the UART is idle.
+// called by printf() and the timer interrupt; the caller must
+// not hold any other lock.
+void
+uartkick(void)
+{
+  acquire(&tx_lock);
+  uartstart();
+  release(&tx_lock);
+}
+
+// called by klog_commit() when a CPU's log ring is full of
+// text the UART has not sent yet: send everything pending
+// synchronously, in order, so the ring can be reused.
+// the caller may hold other locks, so this gives up if tx_lock
+// is busy rather than spinning, and does not call wakeup();
+// the next transmit interrupt wakes any waiting writers.
+// returns 1 if the output was drained, 0 if tx_lock was busy.
+int
+uartdrain(void)
+{
+  if(panicked || !tryacquire(&tx_lock))
+    return 0;
+
+  for(;;){
+    uartfill();
+    if(tx_r == tx_w)
+      break;
+    while((ReadReg(LSR) & LSR_TX_IDLE) == 0)
+      ;
+    for(int k = 0; k < UART_FIFO_SIZE && tx_r != tx_w; k++)
+      WriteReg(THR, tx_buf[tx_r++ % UART_TX_BUF_SIZE]);
+  }
+
+  release(&tx_lock);
+  return 1;
+}
+
+// called by panic(): synchronously send everything still
+// buffered. tx_lock may be held by a CPU that will never
+// release it, so this does not take it.
+void
+uartpanicflush(void)
+{
+  char buf[32];
+  int n;
+
+  while(tx_r != tx_w)
+    uartputc_sync(tx_buf[tx_r++ % UART_TX_BUF_SIZE]);
+  while((n = klog_console(buf, sizeof(buf))) > 0)
+    for(int i = 0; i < n; i++)
+      uartputc_sync(buf[i]);
+}
+
 // read one input character from the UART.
 // return -1 if none is waiting.
 int
@@ -144,12 +252,9 @@ uartintr(void)
 {
   ReadReg(ISR); // acknowledge the interrupt
 
+  // send buffered characters.
   acquire(&tx_lock);
-  if(ReadReg(LSR) & LSR_TX_IDLE){
-    // UART finished transmitting; wake up sending thread.
-    tx_busy = 0;
-    wakeup(&tx_chan);
-  }
+  uartstart();
   release(&tx_lock);
 
   // read and process incoming characters.
@@ -15,6 +15,8 @@
 #include "fs.h"
 #include "buf.h"
 #include "virtio.h"
+#include "sysinfo.h"
+#include "tracepoint.h"
 
 // the address of virtio mmio register r.
 #define R(r) ((volatile uint32 *)(VIRTIO0 + (r)))
@@ -55,6 +57,9 @@ static struct disk {
   struct virtio_blk_req ops[NUM];
   
   struct spinlock vdisk_lock;
+
+  uint64 nread;   // requests issued, protected by vdisk_lock
+  uint64 nwrite;
   
 } disk;
 
@@ -123,9 +128,9 @@ virtio_disk_init(void)
   disk.used = kalloc();
   if(!disk.desc || !disk.avail || !disk.used)
     panic("virtio disk kalloc");
-  memset(disk.desc, 0, PGSIZE);
-  memset(disk.avail, 0, PGSIZE);
-  memset(disk.used, 0, PGSIZE);
+  zero_page(disk.desc);
+  zero_page(disk.avail);
+  zero_page(disk.used);
 
   // set queue size.
   *R(VIRTIO_MMIO_QUEUE_NUM) = NUM;
@@ -218,6 +223,10 @@ virtio_disk_rw(struct buf *b, int write)
   uint64 sector = b->blockno * (BSIZE / 512);
 
   acquire(&disk.vdisk_lock);
+  if(write)
+    disk.nwrite++;
+  else
+    disk.nread++;
 
   // the spec's Section 5.2 says that legacy block operations use
   // three descriptors: one for type/reserved/sector, one for the
@@ -279,6 +288,7 @@ virtio_disk_rw(struct buf *b, int write)
   __sync_synchronize();
 
   *R(VIRTIO_MMIO_QUEUE_NOTIFY) = 0; // value is queue number
+  TP(TP_DISK_SUBMIT, b->blockno, write);
 
   // Wait for virtio_disk_intr() to say request has finished.
   while(b->disk == 1) {
@@ -318,6 +328,7 @@ virtio_disk_intr()
 
     struct buf *b = disk.info[id].b;
     b->disk = 0;   // disk is done with buf
+    TP(TP_DISK_DONE, b->blockno, 0);
     wakeup(b);
 
     disk.used_idx += 1;
@@ -325,3 +336,13 @@ virtio_disk_intr()
 
   release(&disk.vdisk_lock);
 }
+
+// Fill in the disk part of a sysinfo snapshot.
+void
+diskstat(struct sysinfo *si)
+{
+  acquire(&disk.vdisk_lock);
+  si->disk_reads = disk.nread;
+  si->disk_writes = disk.nwrite;
+  release(&disk.vdisk_lock);
+}
@@ -7,6 +7,8 @@
 #include "spinlock.h"
 #include "proc.h"
 #include "fs.h"
+#include "faultstat.h"
+#include "tracepoint.h"
 
 /*
  * the kernel's page table.
@@ -24,7 +26,7 @@ kvmmake(void)
   pagetable_t kpgtbl;
 
   kpgtbl = (pagetable_t) kalloc();
-  memset(kpgtbl, 0, PGSIZE);
+  zero_page(kpgtbl);
 
   // uart registers
   kvmmap(kpgtbl, UART0, UART0, PGSIZE, PTE_R | PTE_W);
@@ -45,9 +47,9 @@ kvmmake(void)
   // the highest virtual address in the kernel.
   kvmmap(kpgtbl, TRAMPOLINE, (uint64)trampoline, PGSIZE, PTE_R | PTE_X);
 
-  // allocate and map a kernel stack for each process.
-  proc_mapstacks(kpgtbl);
-  
+  // kernel stacks are mapped as processes are created;
+  // see procnew() in proc.c.
+
   return kpgtbl;
 }
 
@@ -107,7 +109,7 @@ walk(pagetable_t pagetable, uint64 va, int alloc)
     } else {
       if(!alloc || (pagetable = (pde_t*)kalloc()) == 0)
         return 0;
-      memset(pagetable, 0, PGSIZE);
+      zero_page(pagetable);
       *pte = PA2PTE(pagetable) | PTE_V;
     }
   }
@@ -182,7 +184,7 @@ uvmcreate()
   pagetable = (pagetable_t) kalloc();
   if(pagetable == 0)
     return 0;
-  memset(pagetable, 0, PGSIZE);
+  zero_page(pagetable);
   return pagetable;
 }
 
@@ -230,7 +232,7 @@ uvmalloc(pagetable_t pagetable, uint64 oldsz, uint64 newsz, int xperm)
       uvmdealloc(pagetable, a, oldsz);
       return 0;
     }
-    memset(mem, 0, PGSIZE);
+    zero_page(mem);
     if(mappages(pagetable, a, PGSIZE, (uint64)mem, PTE_R|PTE_U|xperm) != 0){
       kfree(mem);
       uvmdealloc(pagetable, a, oldsz);
@@ -288,6 +290,24 @@ uvmfree(pagetable_t pagetable, uint64 sz)
   freewalk(pagetable);
 }
 
+// Free user memory pages and every page-table page except
+// the ones on the path to TRAMPOLINE and TRAPFRAME, leaving
+// pagetable as proc_pagetable() built it.
+void
+uvmreset(pagetable_t pagetable, uint64 sz)
+{
+  int top = PX(2, TRAPFRAME);
+
+  if(sz > 0)
+    uvmunmap(pagetable, 0, PGROUNDUP(sz)/PGSIZE, 1);
+  for(int i = 0; i < 512; i++){
+    if(i != top && (pagetable[i] & PTE_V)){
+      freewalk((pagetable_t)PTE2PA(pagetable[i]));
+      pagetable[i] = 0;
+    }
+  }
+}
+
 // Given a parent process's page table, copy
 // its memory into a child's page table.
 // COW开关：设置为0禁用COW，使用传统的内存复制
@@ -350,7 +370,7 @@ uvmcopy(pagetable_t old, pagetable_t new, uint64 sz)
     flags = PTE_FLAGS(*pte);
     if((mem = kalloc()) == 0)
       goto err;
-    memmove(mem, (char*)pa, PGSIZE);
+    copy_page(mem, (char*)pa);
     if(mappages(new, i, PGSIZE, (uint64)mem, flags) != 0){
       kfree(mem);
       goto err;
@@ -377,8 +397,8 @@ uvmclear(pagetable_t pagetable, uint64 va)
   *pte &= ~PTE_U;
 }
 
-// COW: Handle copy-on-write page fault
-// Returns 0 on success, -1 on failure
+// COW: Handle copy-on-write page fault.
+// Returns FAULT_COW_COPY or FAULT_COW_REUSE on success, -1 on failure.
 int
 cowhandler(pagetable_t pagetable, uint64 va)
 {
@@ -396,13 +416,22 @@ cowhandler(pagetable_t pagetable, uint64 va)
   uint64 pa = PTE2PA(*pte);
   uint flags = PTE_FLAGS(*pte);
   
+  // Nobody else maps the page any more (the other sharers have
+  // exited or broken their own COW), so it can simply be made
+  // writable again. Only a fork by this process could add a
+  // sharer, and that can't happen while we are here.
+  if(krefcount((void*)pa) == 1){
+    *pte = (*pte & ~PTE_COW) | PTE_W;
+    return FAULT_COW_REUSE;
+  }
+
   // Allocate new page
   char *mem = kalloc();
   if(mem == 0)
     return -1;
     
   // Copy old page to new page
-  memmove(mem, (char*)pa, PGSIZE);
+  copy_page(mem, (char*)pa);
   
   // Update PTE: remove COW flag, add write permission
   flags = (flags & ~PTE_COW) | PTE_W;
@@ -413,6 +442,36 @@ cowhandler(pagetable_t pagetable, uint64 va)
   // Decrease reference count of old page
   kunrefpage((void*)pa);
   
+  return FAULT_COW_COPY;
+}
+
+// handle a user page fault at va; write is 1 for a store.
+// returns 0 if the access can be retried, -1 for a real fault.
+int
+uvmfault(pagetable_t pagetable, uint64 va, int write)
+{
+  uint64 t0 = r_cycle();
+  pte_t *pte;
+  int type;
+
+  if(va >= MAXVA)
+    return -1;
+  pte = walk(pagetable, va, 0);
+  if(pte && (*pte & (PTE_V|PTE_U)) == (PTE_V|PTE_U) &&
+     (*pte & (write ? PTE_W : PTE_R))){
+    // already allowed, e.g. a stale TLB entry; the return
+    // to user space flushes the TLB.
+    type = FAULT_SPURIOUS;
+  } else if(write && pte && (*pte & PTE_COW)){
+    if((type = cowhandler(pagetable, va)) < 0)
+      return -1;
+  } else if(vmfault(pagetable, va, !write) != 0){
+    type = FAULT_LAZY;
+  } else {
+    return -1;
+  }
+  faultrecord(type, r_cycle() - t0);
+  TP(TP_FAULT, va, type);
   return 0;
 }
 
@@ -436,8 +495,11 @@ copyout(pagetable_t pagetable, uint64 dstva, char *src, uint64 len)
     
     // COW: If page is COW, handle it before writing
     if(*pte & PTE_COW) {
-      if(cowhandler(pagetable, va0) < 0)
+      uint64 t0 = r_cycle();
+      int type;
+      if((type = cowhandler(pagetable, va0)) < 0)
         return -1;
+      faultrecord(type, r_cycle() - t0);
       // Reload PTE after COW handling
       pte = walk(pagetable, va0, 0);
     }
@@ -474,9 +536,11 @@ copyin(pagetable_t pagetable, char *dst, uint64 srcva, uint64 len)
     va0 = PGROUNDDOWN(srcva);
     pa0 = walkaddr(pagetable, va0);
     if(pa0 == 0) {
+      uint64 t0 = r_cycle();
       if((pa0 = vmfault(pagetable, va0, 0)) == 0) {
         return -1;
       }
+      faultrecord(FAULT_LAZY, r_cycle() - t0);
     }
     n = PGSIZE - (srcva - va0);
     if(n > len)
@@ -493,14 +557,24 @@ copyin(pagetable_t pagetable, char *dst, uint64 srcva, uint64 len)
 // Copy a null-terminated string from user to kernel.
 // Copy bytes to dst from virtual address srcva in a given page table,
 // until a '\0', or max.
-// Return 0 on success, -1 on error.
+// Return the length of the string (not counting the '\0') on
+// success, -1 on error.
+//
+// once src and dst are both 8-byte aligned, whole words are
+// copied and tested for a zero byte with HASZERO, so the byte
+// loop only runs for the unaligned head and the word holding
+// the terminator.
+#define ONES  0x0101010101010101UL
+#define HIGHS 0x8080808080808080UL
+#define HASZERO(w) (((w) - ONES) & ~(w) & HIGHS)
+
 int
 copyinstr(pagetable_t pagetable, char *dst, uint64 srcva, uint64 max)
 {
   uint64 n, va0, pa0;
-  int got_null = 0;
+  char *start = dst;
 
-  while(got_null == 0 && max > 0){
+  while(max > 0){
     va0 = PGROUNDDOWN(srcva);
     pa0 = walkaddr(pagetable, va0);
     if(pa0 == 0)
@@ -508,29 +582,32 @@ copyinstr(pagetable_t pagetable, char *dst, uint64 srcva, uint64 max)
     n = PGSIZE - (srcva - va0);
     if(n > max)
       n = max;
+    max -= n;
 
     char *p = (char *) (pa0 + (srcva - va0));
-    while(n > 0){
-      if(*p == '\0'){
-        *dst = '\0';
-        got_null = 1;
-        break;
-      } else {
-        *dst = *p;
+    while(n > 0 && ((uint64)p & 7) != 0){
+      if((*dst = *p) == '\0')
+        return dst - start;
+      n--, p++, dst++;
+    }
+    if(((uint64)dst & 7) == 0){
+      while(n >= 8){
+        uint64 w = *(uint64 *)p;
+        if(HASZERO(w))
+          break;
+        *(uint64 *)dst = w;
+        n -= 8, p += 8, dst += 8;
       }
-      --n;
-      --max;
-      p++;
-      dst++;
+    }
+    while(n > 0){
+      if((*dst = *p) == '\0')
+        return dst - start;
+      n--, p++, dst++;
     }
 
     srcva = va0 + PGSIZE;
   }
-  if(got_null){
-    return 0;
-  } else {
-    return -1;
-  }
+  return -1;
 }
 
 // allocate and map user memory if process is referencing a page
@@ -552,7 +629,7 @@ vmfault(pagetable_t pagetable, uint64 va, int read)
   mem = (uint64) kalloc();
   if(mem == 0)
     return 0;
-  memset((void *) mem, 0, PGSIZE);
+  zero_page((void *) mem);
   if (mappages(p->pagetable, va, PGSIZE, mem, PTE_W|PTE_U|PTE_R) != 0) {
     kfree((void *)mem);
     return 0;
@@ -0,0 +1,114 @@
+#!/usr/bin/env python3
+
+#
+# turn the samples printed by xv6's prof tool into folded stacks
+# for flamegraph.pl or speedscope.
+#
+# ./prof2folded.py console.log > out.folded
+# make qemu | tee console.log, then run "prof cmd" inside xv6.
+#
+# kernel addresses are looked up in kernel/kernel.sym, user
+# addresses in user/<name>.sym where <name> is the process name
+# recorded with the sample. kernel frames get a "_[k]" suffix.
+#
+
+import argparse, bisect, collections, os, re, sys
+
+parser = argparse.ArgumentParser()
+parser.add_argument('logs', nargs='*', help="console output (default stdin)")
+parser.add_argument('--kernel-sym', default='kernel/kernel.sym')
+parser.add_argument('--user-dir', default='user')
+parser.add_argument('--pid', type=int, action='append',
+                    help="only samples from this pid (repeatable)")
+parser.add_argument('--no-idle', action='store_true',
+                    help="drop samples taken in the scheduler")
+args = parser.parse_args()
+
+SAMPLE = re.compile(r'\[sample\] (.*)$')
+
+class Symbols(object):
+
+    def __init__(self, path):
+        self.addrs = []
+        self.names = []
+        if not os.path.exists(path):
+            return
+        syms = []
+        with open(path) as f:
+            for line in f:
+                parts = line.split()
+                if len(parts) != 2:
+                    continue
+                addr, name = parts
+                # skip section names and local labels.
+                if name.startswith('.') or name.startswith('$'):
+                    continue
+                try:
+                    syms.append((int(addr, 16), name))
+                except ValueError:
+                    pass
+        syms.sort()
+        self.addrs = [a for a, _ in syms]
+        self.names = [n for _, n in syms]
+
+    def lookup(self, addr):
+        i = bisect.bisect_right(self.addrs, addr) - 1
+        if i < 0:
+            return None
+        return self.names[i]
+
+kernel = Symbols(args.kernel_sym)
+users = {}
+
+def usersyms(name):
+    if name not in users:
+        users[name] = Symbols(os.path.join(args.user_dir, name + '.sym'))
+    return users[name]
+
+def frame(addr, user, name, ret):
+    # a return address points after the call, which may be
+    # the first instruction of the next function.
+    a = addr - 1 if ret else addr
+    if user:
+        f = usersyms(name).lookup(a)
+        return f if f else '%s+0x%x' % (name, addr)
+    f = kernel.lookup(a)
+    return (f if f else '0x%x' % addr) + '_[k]'
+
+def parse(line):
+    m = SAMPLE.search(line)
+    if not m:
+        return None
+    kv = dict(item.split('=', 1) for item in m.group(1).split() if '=' in item)
+    try:
+        s = {
+            'pid': int(kv['pid']),
+            'user': kv['user'] == '1',
+            'name': kv['name'],
+            'pc': int(kv['pc'], 16),
+            'stack': [int(x, 16) for x in kv.get('stack', '').split(',') if x],
+        }
+    except (KeyError, ValueError):
+        return None
+    return s
+
+def main():
+    counts = collections.Counter()
+    files = [open(p, errors='replace') for p in args.logs] or [sys.stdin]
+    for f in files:
+        for line in f:
+            s = parse(line)
+            if s is None:
+                continue
+            if args.pid and s['pid'] not in args.pid:
+                continue
+            if args.no_idle and s['pid'] == 0:
+                continue
+            frames = [frame(s['pc'], s['user'], s['name'], False)]
+            frames += [frame(a, s['user'], s['name'], True) for a in s['stack']]
+            frames.append(s['name'])
+            counts[';'.join(reversed(frames))] += 1
+    for stack, n in sorted(counts.items()):
+        print('%s %d' % (stack, n))
+
+main()
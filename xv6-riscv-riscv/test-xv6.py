@@ -7,22 +7,39 @@
 # ./test-xv6.py -q usertests (runs the quick tests of usertests)
 # ./test-xv6.py crash  (runs the crash tests)
 # ./test-xv6.py log (runs the log crash test)
+# ./test-xv6.py bench (runs the benchmarks, see test_bench)
+# ./test-xv6.py bench --cpus 4 --out new.json --baseline old.json
+# ./test-xv6.py scale (bench_scale at several CPUS, speedup table)
 
-import argparse, os, inspect, re, signal, subprocess, sys, time
+import argparse, json, os, inspect, re, signal, subprocess, sys, time
 from subprocess import run
 
 parser = argparse.ArgumentParser()
 parser.add_argument('testrex', help="test name or regular expression")
 parser.add_argument("-q", action='store_true', help="usertests quick")
+parser.add_argument("--cpus", type=int, default=3, help="bench: harts to boot")
+parser.add_argument("--mem", default="128M", help="bench: qemu -m")
+parser.add_argument("--runs", type=int, default=3,
+                    help="bench: runs per benchmark, the median is kept")
+parser.add_argument("--bench", action='append',
+                    help="bench: only these programs (repeatable)")
+parser.add_argument("--out", default="bench.json", help="bench: results file")
+parser.add_argument("--baseline", help="bench: results to compare against")
+parser.add_argument("--threshold", type=float, default=0.10,
+                    help="bench: allowed relative regression (0.10 = 10%%)")
+parser.add_argument("--timeout", type=int, default=600,
+                    help="bench: seconds for the whole run")
+parser.add_argument("--scale-cpus", default="1 2 4 8",
+                    help="scale: CPUS values to boot with")
 args = parser.parse_args()
 
 class QEMU(object):
 
-    def __init__(self, reset=False):
+    def __init__(self, reset=False, makeargs=[]):
         if reset:
             self.build_xv6()
             self.reset_fs()
-        q = ["make", "qemu"]
+        q = ["make", "qemu"] + makeargs
         self.proc = subprocess.Popen(q, stdin=subprocess.PIPE,
                                       stdout=subprocess.PIPE,
                                       stderr=subprocess.STDOUT)
@@ -199,6 +216,174 @@ def test_usertests(test=""):
     q.monitor('^ALL TESTS PASSED', progress='test', timeout=timeout)
     q.stop()
 
+# benchmarks run by "bench": program and arguments. each prints
+# lines of the form "[name] key=value ...".
+BENCHMARKS = [
+    ["bench_cow"],
+    ["bench_fork"],
+    ["bench_page"],
+    ["bench_batch"],
+    ["microbench", "-n", "500"],
+    ["bench_scale", "-t", "1000"],
+]
+
+BENCHLINE = re.compile(r'^\[([^\]]+)\] (.*)$')
+
+# direction of a metric, from its key: -1 lower is better,
+# 1 higher is better, 0 not compared (sizes, counts).
+def direction(key):
+    if 'per_s' in key:
+        return 1
+    if key.endswith('_ns') or key.startswith('ns_') or 'cycles' in key:
+        return -1
+    return 0
+
+def number(v):
+    # bench programs print fixed point as "12.34".
+    try:
+        return float(v)
+    except ValueError:
+        return None
+
+# parse one program's output into {line id: {key: value}}. the id
+# is the bracketed name plus any non-numeric fields (scenario=...),
+# so repeated lines from different scenarios stay apart.
+def parse_bench(lines):
+    res = {}
+    for line in lines:
+        m = BENCHLINE.match(line)
+        if not m:
+            continue
+        kv = [item.split('=', 1) for item in m.group(2).split() if '=' in item]
+        ident = [m.group(1)] + ['%s=%s' % (k, v) for k, v in kv if number(v) is None]
+        vals = {k: number(v) for k, v in kv if number(v) is not None}
+        if vals:
+            res[' '.join(ident)] = vals
+    return res
+
+def median(xs):
+    xs = sorted(xs)
+    n = len(xs)
+    return xs[n // 2] if n % 2 else (xs[n // 2 - 1] + xs[n // 2]) / 2
+
+# boot once with an initrc that runs every benchmark args.runs
+# times, and split the console output at init's markers.
+def run_benchmarks(benches, cpus):
+    with open("initrc", "w") as f:
+        for _ in range(args.runs):
+            for b in benches:
+                f.write(' '.join(b) + '\n')
+    q = None
+    try:
+        q = QEMU(True, ["CPUS=%d" % cpus, "MEM=%s" % args.mem])
+        q.monitor('^init: initrc completed', progress='^init: run',
+                  timeout=args.timeout)
+    finally:
+        os.remove("initrc")
+        if q:
+            q.stop()
+            q.reset_fs()      # leave an image without initrc behind
+
+    runs = {}
+    cur, out = None, []
+    for line in q.lines():
+        m = re.match(r'^init: (run|done) (\S+)', line)
+        if m and m.group(1) == 'run':
+            cur, out = m.group(2), []
+        elif m and cur is not None:
+            runs.setdefault(cur, []).append(parse_bench(out))
+            cur = None
+        elif cur is not None:
+            out.append(line)
+
+    # median of each value over the runs that produced it.
+    results = {}
+    for prog, rs in runs.items():
+        merged = {}
+        for r in rs:
+            for ident, vals in r.items():
+                for k, v in vals.items():
+                    merged.setdefault(ident, {}).setdefault(k, []).append(v)
+        results[prog] = {ident: {k: median(v) for k, v in vals.items()}
+                         for ident, vals in merged.items()}
+    return results
+
+# compare against a baseline; returns the list of regressions.
+def compare(base, new, threshold):
+    bad = []
+    for prog, lines in sorted(new.items()):
+        for ident, vals in sorted(lines.items()):
+            old = base.get(prog, {}).get(ident)
+            if old is None:
+                continue
+            for k, v in sorted(vals.items()):
+                d = direction(k)
+                if d == 0 or k not in old or old[k] == 0:
+                    continue
+                change = (v - old[k]) / old[k]
+                worse = -change * d
+                mark = "REGRESSED" if worse > threshold else "ok"
+                print("%-10s %s %s: %g -> %g (%+.1f%%) %s" %
+                      (prog, ident, k, old[k], v, change * 100, mark))
+                if worse > threshold:
+                    bad.append((prog, ident, k))
+    return bad
+
+def test_bench():
+    benches = [b for b in BENCHMARKS if not args.bench or b[0] in args.bench]
+    print("bench: cpus=%d mem=%s runs=%d" % (args.cpus, args.mem, args.runs))
+    results = run_benchmarks(benches, args.cpus)
+    missing = [b[0] for b in benches if b[0] not in results]
+    if missing:
+        print("FAIL: no output from", ' '.join(missing))
+        sys.exit(1)
+
+    doc = {
+        'config': {'cpus': args.cpus, 'mem': args.mem, 'runs': args.runs},
+        'results': results,
+    }
+    with open(args.out, "w") as f:
+        json.dump(doc, f, indent=2, sort_keys=True)
+    print("bench: results in", args.out)
+
+    if args.baseline:
+        with open(args.baseline) as f:
+            base = json.load(f)
+        if base.get('config', {}).get('cpus') != args.cpus:
+            print("bench: warning: baseline was run with cpus=%s" %
+                  base.get('config', {}).get('cpus'))
+        bad = compare(base['results'], results, args.threshold)
+        if bad:
+            print("FAIL: %d metrics regressed by more than %.0f%%" %
+                  (len(bad), args.threshold * 100))
+            sys.exit(1)
+    print("OK")
+
+# boot with each CPUS value, run bench_scale with one worker per
+# hart, and print ops/s and the speedup over one hart per mix.
+def test_scale():
+    cpus = [int(c) for c in args.scale_cpus.split()]
+    rates = {}          # mix -> {cpus: ops_per_s}
+    for c in cpus:
+        print("scale: cpus=%d" % c)
+        res = run_benchmarks([["bench_scale", "-n", str(c)]], c)
+        for ident, vals in res.get('bench_scale', {}).items():
+            mix = ident.split('-')[0]
+            rates.setdefault(mix, {})[c] = vals.get('ops_per_s', 0)
+    if not rates:
+        print("FAIL: no output from bench_scale")
+        sys.exit(1)
+
+    print("%-8s" % "mix" + "".join("%18s" % ("cpus=%d" % c) for c in cpus))
+    for mix, r in sorted(rates.items()):
+        base = r.get(cpus[0]) or 1
+        cells = ["%10d %6.2fx" % (r[c], r[c] / base) if c in r else "%18s" % "-"
+                 for c in cpus]
+        print("%-8s" % mix + "".join(cells))
+    with open("scale.json", "w") as f:
+        json.dump({'cpus': cpus, 'ops_per_s': rates}, f, indent=2, sort_keys=True)
+    print("OK")
+
 def main():
     print(args)
     rex = r'%s' % args.testrex
@@ -0,0 +1,158 @@
+#!/usr/bin/env python3
+
+#
+# turn the records printed by xv6's tpdump tool into a
+# Chrome trace-event JSON timeline, for chrome://tracing
+# or ui.perfetto.dev.
+#
+# ./tp2chrome.py console.log > trace.json
+# make qemu | tee console.log, then run "tpdump cmd" inside xv6.
+#
+# the timeline has three groups:
+#   cpus       one track per hart: which pid is running, plus
+#              instant events (wakeup, kalloc, bget, fault, ...)
+#              and a flow arrow from each wakeup to the moment
+#              the woken process next runs
+#   processes  one track per pid: time spent waiting in
+#              begin_op and in commit
+#   disk       one async slice per request, submit to interrupt
+#
+
+import argparse, json, re, sys
+
+parser = argparse.ArgumentParser()
+parser.add_argument('logs', nargs='*', help="console output (default stdin)")
+parser.add_argument('--no-alloc', action='store_true',
+                    help="drop kalloc/kfree events")
+args = parser.parse_args()
+
+RECORD = re.compile(r'\[tp\] (.*)$')
+
+CPUS, PROCS, DISK = 0, 1, 2
+
+def parse(line):
+    m = RECORD.search(line)
+    if not m:
+        return None
+    kv = dict(item.split('=', 1) for item in m.group(1).split() if '=' in item)
+    if 'freq' in kv:
+        return {'freq': int(kv['freq'])}
+    try:
+        return {
+            't': int(kv['t']),
+            'cpu': int(kv['cpu']),
+            'pid': int(kv['pid']),
+            'ev': kv['ev'],
+            'a0': int(kv['a0'], 16),
+            'a1': int(kv['a1'], 16),
+        }
+    except (KeyError, ValueError):
+        return None
+
+def main():
+    freq = 10000000
+    recs = []
+    files = [open(p, errors='replace') for p in args.logs] or [sys.stdin]
+    for f in files:
+        for line in f:
+            r = parse(line)
+            if r is None:
+                continue
+            if 'freq' in r:
+                freq = r['freq']
+            else:
+                recs.append(r)
+    # records arrive grouped by cpu; the time counter is
+    # synchronized across harts, so a stable sort merges them.
+    recs.sort(key=lambda r: r['t'])
+    if not recs:
+        json.dump({'traceEvents': []}, sys.stdout)
+        return
+    t0 = recs[0]['t']
+
+    def us(t):
+        return (t - t0) * 1e6 / freq
+
+    out = []
+    running = {}    # cpu -> pid of the open slice
+    pending = {}    # woken pid -> flow id
+    disk = {}       # blockno -> request name
+    cpus, pids = set(), set()
+    flow = 0
+
+    for r in recs:
+        ts, cpu, pid, ev = us(r['t']), r['cpu'], r['pid'], r['ev']
+        a0, a1 = r['a0'], r['a1']
+        cpus.add(cpu)
+        if ev == 'sched_in':
+            running[cpu] = pid
+            out.append({'ph': 'B', 'pid': CPUS, 'tid': cpu, 'ts': ts,
+                        'name': 'pid %d' % pid})
+            if pid in pending:
+                out.append({'ph': 'f', 'bp': 'e', 'pid': CPUS, 'tid': cpu,
+                            'ts': ts, 'name': 'wakeup', 'cat': 'wakeup',
+                            'id': pending.pop(pid)})
+        elif ev == 'sched_out':
+            # the trace may start while a process is running.
+            if running.pop(cpu, None) is not None:
+                out.append({'ph': 'E', 'pid': CPUS, 'tid': cpu, 'ts': ts,
+                            'args': {'state': a0}})
+        elif ev == 'wakeup':
+            flow += 1
+            pending[a0] = flow
+            out.append({'ph': 'i', 's': 't', 'pid': CPUS, 'tid': cpu,
+                        'ts': ts, 'name': 'wakeup',
+                        'args': {'pid': a0, 'chan': hex(a1)}})
+            out.append({'ph': 's', 'pid': CPUS, 'tid': cpu, 'ts': ts,
+                        'name': 'wakeup', 'cat': 'wakeup', 'id': flow})
+        elif ev in ('kalloc', 'kfree'):
+            if not args.no_alloc:
+                out.append({'ph': 'i', 's': 't', 'pid': CPUS, 'tid': cpu,
+                            'ts': ts, 'name': ev, 'args': {'pa': hex(a0)}})
+        elif ev in ('bget_hit', 'bget_miss'):
+            out.append({'ph': 'i', 's': 't', 'pid': CPUS, 'tid': cpu,
+                        'ts': ts, 'name': ev,
+                        'args': {'block': a0, 'dev': a1}})
+        elif ev == 'fault':
+            out.append({'ph': 'i', 's': 't', 'pid': CPUS, 'tid': cpu,
+                        'ts': ts, 'name': 'fault',
+                        'args': {'va': hex(a0), 'type': a1}})
+        elif ev == 'begin_op':
+            pids.add(pid)
+            out.append({'ph': 'B', 'pid': PROCS, 'tid': pid, 'ts': ts,
+                        'name': 'begin_op'})
+        elif ev == 'begin_op_done':
+            pids.add(pid)
+            out.append({'ph': 'E', 'pid': PROCS, 'tid': pid, 'ts': ts,
+                        'args': {'waits': a0}})
+        elif ev == 'commit':
+            pids.add(pid)
+            out.append({'ph': 'B', 'pid': PROCS, 'tid': pid, 'ts': ts,
+                        'name': 'commit', 'args': {'blocks': a0}})
+        elif ev == 'commit_done':
+            pids.add(pid)
+            out.append({'ph': 'E', 'pid': PROCS, 'tid': pid, 'ts': ts})
+        elif ev == 'disk_submit':
+            name = 'write' if a1 else 'read'
+            disk[a0] = name
+            out.append({'ph': 'b', 'pid': DISK, 'tid': 0, 'ts': ts,
+                        'name': name, 'cat': 'disk', 'id': a0,
+                        'args': {'block': a0, 'pid': pid}})
+        elif ev == 'disk_done':
+            if a0 in disk:
+                out.append({'ph': 'e', 'pid': DISK, 'tid': 0, 'ts': ts,
+                            'name': disk.pop(a0), 'cat': 'disk', 'id': a0})
+
+    meta = [
+        {'ph': 'M', 'pid': CPUS, 'name': 'process_name', 'args': {'name': 'cpus'}},
+        {'ph': 'M', 'pid': PROCS, 'name': 'process_name', 'args': {'name': 'processes'}},
+        {'ph': 'M', 'pid': DISK, 'name': 'process_name', 'args': {'name': 'disk'}},
+    ]
+    meta += [{'ph': 'M', 'pid': CPUS, 'tid': c, 'name': 'thread_name',
+              'args': {'name': 'cpu %d' % c}} for c in sorted(cpus)]
+    meta += [{'ph': 'M', 'pid': PROCS, 'tid': p, 'name': 'thread_name',
+              'args': {'name': 'pid %d' % p}} for p in sorted(pids)]
+    json.dump({'traceEvents': meta + out, 'displayTimeUnit': 'ns'}, sys.stdout)
+    print()
+
+main()
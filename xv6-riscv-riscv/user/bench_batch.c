@@ -0,0 +1,125 @@
+
+// user/bench_batch.c - 批量系统调用开销基准测试
+
+//
+// 对比两种方式执行同样的系统调用序列：
+// 1. single: 每个系统调用单独陷入内核（ecall → usertrap → sret）
+// 2. batch:  通过 syscall_batch() 一次陷入执行整组调用
+//
+// 测试场景：
+// 1. getpid: 空系统调用，几乎全是陷入/返回开销
+// 2. open/fstat/read/close: 典型的小文件访问链，
+//    batch 版本用 argref 把 open 返回的 fd 传给后续调用
+//
+// 输出格式为 key=value，便于脚本解析
+//
+
+#include "kernel/types.h"
+#include "kernel/stat.h"
+#include "kernel/fcntl.h"
+#include "kernel/syscall.h"
+#include "kernel/sysbatch.h"
+#include "user/user.h"
+
+#define BATCH 32        // 每批 getpid 个数
+
+static struct sysop ops[MAXBATCH];
+static char buf[64];
+static struct stat st;
+
+/**
+ * 打印一组结果
+ * @param name   场景名
+ * @param calls  系统调用总数
+ * @param ns     总耗时（纳秒）
+ * @param cycles 总周期数
+ */
+static void report(char *name, int calls, uint64 ns, uint64 cycles){
+  printf("[%s] calls=%d total_ns=%lu ns_per_call=%lu cycles_per_call=%lu\n",
+         name, calls, ns, ns / calls, cycles / calls);
+}
+
+// 场景1：空系统调用
+
+static void bench_getpid(int iters){
+  uint64 t0, t1, c0, c1;
+
+  t0 = nsecs(); c0 = rdcycle();
+  for(int i = 0; i < iters; i++)
+    getpid();
+  c1 = rdcycle(); t1 = nsecs();
+  report("getpid-single", iters, t1 - t0, c1 - c0);
+
+  for(int i = 0; i < BATCH; i++){
+    ops[i].num = SYS_getpid;
+    ops[i].flags = 0;
+    ops[i].argref = 0;
+  }
+  int batches = iters / BATCH;
+  t0 = nsecs(); c0 = rdcycle();
+  for(int i = 0; i < batches; i++){
+    if(syscall_batch(ops, BATCH) != BATCH){
+      printf("bench_batch: getpid batch failed\n");
+      exit(1);
+    }
+  }
+  c1 = rdcycle(); t1 = nsecs();
+  report("getpid-batch", batches * BATCH, t1 - t0, c1 - c0);
+}
+
+// 场景2：open/fstat/read/close 调用链
+
+static void bench_chain(char *path, int iters){
+  uint64 t0, t1, c0, c1;
+
+  t0 = nsecs(); c0 = rdcycle();
+  for(int i = 0; i < iters; i++){
+    int fd = open(path, O_RDONLY);
+    if(fd < 0){
+      printf("bench_batch: open %s failed\n", path);
+      exit(1);
+    }
+    fstat(fd, &st);
+    read(fd, buf, sizeof(buf));
+    close(fd);
+  }
+  c1 = rdcycle(); t1 = nsecs();
+  report("chain-single", iters * 4, t1 - t0, c1 - c0);
+
+  // op0: open(path)；op1-3 的第 0 个参数引用 op0 的返回值（fd）
+  ops[0] = (struct sysop){ .num = SYS_open, .flags = SOP_STOPERR,
+                           .args = { (uint64)path, O_RDONLY } };
+  ops[1] = (struct sysop){ .num = SYS_fstat, .argref = 1,
+                           .args = { 0, (uint64)&st } };
+  ops[2] = (struct sysop){ .num = SYS_read, .argref = 1,
+                           .args = { 0, (uint64)buf, sizeof(buf) } };
+  ops[3] = (struct sysop){ .num = SYS_close, .argref = 1,
+                           .args = { 0 } };
+  t0 = nsecs(); c0 = rdcycle();
+  for(int i = 0; i < iters; i++){
+    if(syscall_batch(ops, 4) != 4 || ops[3].ret < 0){
+      printf("bench_batch: chain batch failed\n");
+      exit(1);
+    }
+  }
+  c1 = rdcycle(); t1 = nsecs();
+  report("chain-batch", iters * 4, t1 - t0, c1 - c0);
+}
+
+int main(int argc, char *argv[]){
+  int iters = 10000;     // getpid 次数
+  int chains = 200;      // 文件访问链次数
+  char *path = "README";
+
+  if(argc >= 2) iters = atoi(argv[1]);
+  if(argc >= 3) chains = atoi(argv[2]);
+  if(argc >= 4) path = argv[3];
+  if(iters < BATCH) iters = BATCH;
+  if(chains < 1) chains = 1;
+
+  printf("bench_batch: iters=%d chains=%d path=%s\n", iters, chains, path);
+  bench_getpid(iters);
+  bench_chain(path, chains);
+  printf("done\n");
+  exit(0);
+}
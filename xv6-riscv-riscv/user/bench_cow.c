@@ -8,6 +8,10 @@
 // 2. touch-1pages: 轻量写入，子进程只写1页
 // 3. touch-128pages: 大量写入，子进程写128页
 //
+// 每个场景之后还打印这段时间内全局的页错误统计（见 faultstat()），
+// 把耗时归到 COW 复制 / 复用、惰性清零等路径上：
+//   [faults] scenario=S cow_copy=N cow_copy_cycles=C cow_reuse=N ... 
+//
 
 
 
@@ -15,17 +19,21 @@
 #include "kernel/stat.h"
 #include "user/user.h"
 #include "kernel/riscv.h" // for PGSIZE
+#include "kernel/param.h"
+#include "kernel/faultstat.h"
 
 
 // 计时工具函数
 
 
 /**
- * 获取当前系统tick数
- * @return 当前tick数（xv6中1tick = 10ms）
+ * 获取当前时间（纳秒）
+ * 直接读 time CSR（用户态 rdtime），分辨率 100ns，
+ * 比 uptime() 的 tick 精度高几个数量级
+ * @return 启动以来的纳秒数
  */
-static inline uint64 now_ticks(){
-  return uptime(); // 10ms per tick
+static inline uint64 now_ns(){
+  return nsecs();
 }
 
 
@@ -38,10 +46,10 @@ static inline uint64 now_ticks(){
  * 这个场景主要测试COW在"只fork不写"情况下的性能优势
  * 
  * @param ops 要执行的fork操作次数
- * @return 执行这些fork操作所花费的tick数
+ * @return 执行这些fork操作所花费的纳秒数
  */
 static uint64 run_forks_no_touch(int ops){
-  uint64 t0 = now_ticks(); // 记录开始时间
+  uint64 t0 = now_ns(); // 记录开始时间
   
   for(int i=0;i<ops;i++){
     int pid = fork();
@@ -56,7 +64,7 @@ static uint64 run_forks_no_touch(int ops){
     wait(0); // 父进程等待子进程结束
   }
   
-  uint64 t1 = now_ticks(); // 记录结束时间
+  uint64 t1 = now_ns(); // 记录结束时间
   return t1 - t0; // 返回总耗时
 }
 
@@ -82,10 +90,10 @@ static void touch_pages(char *base, int pages){
  * @param ops 要执行的fork操作次数
  * @param start 要写入的内存区域起始地址
  * @param pages 每个子进程要写入的页面数量
- * @return 执行这些fork+写入操作所花费的tick数
+ * @return 执行这些fork+写入操作所花费的纳秒数
  */
 static uint64 run_forks_touch(int ops, char *start, int pages){
-  uint64 t0 = now_ticks(); // 记录开始时间
+  uint64 t0 = now_ns(); // 记录开始时间
   
   for(int i=0;i<ops;i++){
     int pid = fork();
@@ -101,11 +109,50 @@ static uint64 run_forks_touch(int ops, char *start, int pages){
     wait(0); // 父进程等待子进程结束
   }
   
-  uint64 t1 = now_ticks(); // 记录结束时间
+  uint64 t1 = now_ns(); // 记录结束时间
   return t1 - t0; // 返回总耗时
 }
 
 
+// 页错误统计
+
+
+static char *faultname[NFAULTTYPE] = {
+  [FAULT_COW_COPY]  "cow_copy",
+  [FAULT_COW_REUSE] "cow_reuse",
+  [FAULT_LAZY]      "lazy",
+  [FAULT_SPURIOUS]  "spurious",
+};
+
+static struct faultstat fs_before;
+
+/**
+ * 记录场景开始时的全局页错误统计
+ */
+static void fault_begin(void){
+  if(faultstat(FAULTSTAT_ALL, &fs_before) < 0)
+    printf("faultstat failed\n");
+}
+
+/**
+ * 打印场景期间各类页错误的次数和平均处理周期数
+ * @param scenario 场景名
+ */
+static void fault_end(char *scenario){
+  struct faultstat fs;
+
+  if(faultstat(FAULTSTAT_ALL, &fs) < 0)
+    return;
+  printf("[faults] scenario=%s", scenario);
+  for(int t=0;t<NFAULTTYPE;t++){
+    uint64 n = fs.count[t] - fs_before.count[t];
+    uint64 c = fs.cycles[t] - fs_before.cycles[t];
+    printf(" %s=%lu %s_cycles=%lu", faultname[t], n, faultname[t], n ? c / n : 0);
+  }
+  printf("\n");
+}
+
+
 // 内存管理辅助函数
 
 
@@ -187,26 +234,34 @@ int main(int argc, char *argv[]){
   // 场景1：no-touch测试 - 纯fork，子进程不写内存
   // 这个场景主要测试COW在"只fork不写"情况下的性能优势
   uint64 total_no = 0;
+  fault_begin();
   for(int r=0;r<rounds;r++) total_no += run_forks_no_touch(ops_no);
   uint64 ops_no_total = (uint64)ops_no * (uint64)rounds;
-  printf("[no-touch] rounds=%d ops=%lu total_ticks=%lu\n",
-         rounds, ops_no_total, total_no);
+  printf("[no-touch] rounds=%d ops=%lu total_ns=%lu ns_per_op=%lu\n",
+         rounds, ops_no_total, total_no, total_no / ops_no_total);
+  fault_end("no-touch");
 
   // 场景2：touch-1pages测试 - 轻量写入，子进程只写1页
   // 这个场景测试COW在少量写入时的性能表现
   uint64 total_small = 0;
+  fault_begin();
   for(int r=0;r<rounds;r++) total_small += run_forks_touch(ops_small, small_region, pages_small);
   uint64 ops_small_total = (uint64)ops_small * (uint64)rounds;
-  printf("[touch-%dpages] rounds=%d ops=%lu total_ticks=%lu\n",
-         pages_small, rounds, ops_small_total, total_small);
+  printf("[touch-%dpages] rounds=%d ops=%lu total_ns=%lu ns_per_op=%lu\n",
+         pages_small, rounds, ops_small_total, total_small,
+         total_small / ops_small_total);
+  fault_end("touch-small");
 
   // 场景3：touch-128pages测试 - 大量写入，子进程写128页
   // 这个场景测试COW在大量写入时的性能表现
   uint64 total_big = 0;
+  fault_begin();
   for(int r=0;r<rounds;r++) total_big += run_forks_touch(ops_big, big_region, pages_big);
   uint64 ops_big_total = (uint64)ops_big * (uint64)rounds;
-  printf("[touch-%dpages] rounds=%d ops=%lu total_ticks=%lu\n",
-         pages_big, rounds, ops_big_total, total_big);
+  printf("[touch-%dpages] rounds=%d ops=%lu total_ns=%lu ns_per_op=%lu\n",
+         pages_big, rounds, ops_big_total, total_big,
+         total_big / ops_big_total);
+  fault_end("touch-big");
 
   // 测试完成
   printf("done\n");
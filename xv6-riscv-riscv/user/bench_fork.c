@@ -0,0 +1,100 @@
+
+// user/bench_fork.c - 进程创建/回收延迟基准测试
+
+//
+// 测试场景：
+// 1. fork_exit: fork 后子进程立即 exit，父进程 wait
+// 2. fork_exec: fork 后子进程 exec 本程序（带参数 -x，立即退出），父进程 wait
+// 3. wait_batch: 先 fork 出 BATCH 个立即退出的子进程，再连续 wait 回收，
+//    只计 wait 的耗时；僵尸进程已在父进程的队列上，每次 wait 应为 O(1)
+//
+// 两个场景都覆盖 allocproc/freeproc 的完整路径：proc 结构体、
+// 内核栈、trapframe 和根页表的获取与回收。连续运行时这些对象
+// 都来自缓存，用于对比缓存前后的延迟
+//
+// 输出格式（key=value）：
+//   [fork_exit] iters=N ns_per_op=T
+//
+
+#include "kernel/types.h"
+#include "user/user.h"
+
+#define ITERS 500
+#define BATCH 64
+
+static char *self;
+
+/**
+ * 运行一个场景并打印每次的平均耗时
+ * @param name  场景名
+ * @param doexec 子进程是否 exec
+ */
+static void
+run(char *name, int doexec)
+{
+  uint64 t0, t1;
+  int i, pid;
+
+  t0 = nsecs();
+  for(i = 0; i < ITERS; i++){
+    if((pid = fork()) < 0){
+      printf("%s: fork failed\n", name);
+      exit(1);
+    }
+    if(pid == 0){
+      if(doexec){
+        char *argv[] = { self, "-x", 0 };
+        exec(self, argv);
+        printf("%s: exec failed\n", name);
+      }
+      exit(0);
+    }
+    wait(0);
+  }
+  t1 = nsecs();
+  printf("[%s] iters=%d ns_per_op=%ld\n", name, ITERS, (t1 - t0) / ITERS);
+}
+
+/**
+ * wait_batch 场景：子进程全部退出后再计时回收
+ */
+static void
+runbatch(void)
+{
+  uint64 t0, t1, total = 0;
+  int i, r, pid;
+
+  for(r = 0; r < ITERS / BATCH; r++){
+    for(i = 0; i < BATCH; i++){
+      if((pid = fork()) < 0){
+        printf("wait_batch: fork failed\n");
+        exit(1);
+      }
+      if(pid == 0)
+        exit(0);
+    }
+    pause(2);                 // 让子进程都变成僵尸
+    t0 = nsecs();
+    for(i = 0; i < BATCH; i++)
+      if(wait(0) < 0){
+        printf("wait_batch: wait failed\n");
+        exit(1);
+      }
+    t1 = nsecs();
+    total += t1 - t0;
+  }
+  printf("[wait_batch] iters=%d ns_per_op=%ld\n", r * BATCH, total / (r * BATCH));
+}
+
+int
+main(int argc, char *argv[])
+{
+  if(argc > 1 && strcmp(argv[1], "-x") == 0)
+    exit(0);
+  self = argv[0];
+
+  run("fork_exit", 0);
+  run("fork_exec", 1);
+  runbatch();
+  exit(0);
+}
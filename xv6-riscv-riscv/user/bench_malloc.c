@@ -0,0 +1,108 @@
+
+// user/bench_malloc.c - malloc/free 微基准测试
+
+//
+// 测试场景：
+// 1. pair:   反复 malloc/free 同一大小（最常见的临时缓冲区用法）
+// 2. batch:  先分配 N 个混合大小的块，再按打乱的顺序释放
+//            （原 K&R 分配器在空闲块多时每次都要遍历链表）
+// 3. large:  分配/释放 64KB 大块（sbrklazy 路径）
+//
+// 输出格式为 key=value，便于脚本解析
+//
+
+#include "kernel/types.h"
+#include "user/user.h"
+
+#define NBATCH 2000
+
+static char *ptrs[NBATCH];
+
+static void
+report(char *name, int ops, uint64 ns)
+{
+  printf("[%s] ops=%d total_ns=%lu ns_per_op=%lu\n",
+         name, ops, ns, ns / ops);
+}
+
+static void
+fail(char *what)
+{
+  printf("bench_malloc: %s failed\n", what);
+  exit(1);
+}
+
+// 场景1：同一大小反复分配释放
+static void
+bench_pair(int iters, uint size)
+{
+  uint64 t0 = nsecs();
+  for(int i = 0; i < iters; i++){
+    char *p = malloc(size);
+    if(p == 0)
+      fail("pair malloc");
+    p[0] = i;
+    free(p);
+  }
+  report("pair", iters * 2, nsecs() - t0);
+}
+
+// 场景2：批量分配混合大小，再乱序释放
+static void
+bench_batch(int rounds)
+{
+  uint seed = 1;
+  uint64 t0 = nsecs();
+
+  for(int r = 0; r < rounds; r++){
+    for(int i = 0; i < NBATCH; i++){
+      seed = seed * 1103515245 + 12345;
+      uint size = 8 + (seed >> 16) % 1024;
+      if((ptrs[i] = malloc(size)) == 0)
+        fail("batch malloc");
+      ptrs[i][0] = i;
+    }
+    // 7919 与 NBATCH 互质，i*7919 % NBATCH 遍历全部下标
+    for(int i = 0; i < NBATCH; i++)
+      free(ptrs[(i * 7919) % NBATCH]);
+  }
+  report("batch", rounds * NBATCH * 2, nsecs() - t0);
+}
+
+// 场景3：大块分配（只触碰第一页）
+static void
+bench_large(int iters)
+{
+  uint64 t0 = nsecs();
+  for(int i = 0; i < iters; i++){
+    char *p = malloc(64 * 1024);
+    if(p == 0)
+      fail("large malloc");
+    p[0] = i;
+    free(p);
+  }
+  report("large", iters * 2, nsecs() - t0);
+}
+
+int
+main(int argc, char *argv[])
+{
+  int iters = 100000;
+  int rounds = 20;
+
+  if(argc >= 2)
+    iters = atoi(argv[1]);
+  if(argc >= 3)
+    rounds = atoi(argv[2]);
+  if(iters < 1)
+    iters = 1;
+  if(rounds < 1)
+    rounds = 1;
+
+  printf("bench_malloc: iters=%d rounds=%d\n", iters, rounds);
+  bench_pair(iters, 64);
+  bench_batch(rounds);
+  bench_large(iters / 100 + 1);
+  printf("done\n");
+  exit(0);
+}
@@ -0,0 +1,257 @@
+
+// user/bench_scale.c - 多核扩展性基准测试
+
+//
+// 用法：
+//   bench_scale [-t ms] [-n workers]... [mix...]
+//
+// 选项：
+//   -t ms       每次测量的时长，默认 2000 毫秒
+//   -n workers  并发的工作进程数，可重复；默认 1 2 4 8
+//   mix         只跑这些负载，默认全部
+//
+// 负载（mix）：
+//   cpu     纯计算，不进内核，衡量调度和时钟中断之外的干扰
+//   alloc   sbrklazy 16 页、逐页写、再缩回：缺页 + kalloc/kfree
+//   file    创建、写 1 字节、关闭、删除各自的文件：日志、inode、目录
+//   pipe    每个工作进程带一个回声进程，1 字节往返：睡眠/唤醒、切换
+//   bcache  反复读同一个 8 块的共享文件：块缓存命中路径和 bcache.lock
+//
+// 每种负载依次用 1、2、4、8 个工作进程各测一次。工作进程先阻塞在
+// 一根管道上，全部创建好后父进程关闭写端，同时放行；各自跑满 -t
+// 后把完成的操作数写回父进程。在 CPUS=8 下运行时，工作进程数
+// 不超过 CPU 数的各点反映内核的扩展性；make scale 在不同 CPUS 下
+// 运行本程序并给出加速比表。
+//
+// 输出格式（key=value）：
+//   [cpu-4workers] workers=4 ms=2000 ops=N ops_per_s=R speedup=S.SS
+//
+// speedup 相对同一负载 1 个工作进程的吞吐量。
+//
+
+#include "kernel/types.h"
+#include "kernel/riscv.h"
+#include "kernel/fcntl.h"
+#include "kernel/fs.h"
+#include "kernel/clock.h"
+#include "user/user.h"
+
+#define MAXWORKERS  16
+#define ALLOCPAGES  16
+#define SHAREDBLKS  8
+#define SHARED      "scale.dat"
+
+static uint64 time_freq;
+static uint64 duration;         // 每次测量的 time 计数
+
+// 一次 cpu 操作：一段不访存的整数运算
+static uint64
+cpu_op(uint64 x)
+{
+  for(int i = 0; i < 1000; i++){
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+  }
+  return x;
+}
+
+static void
+die(char *what)
+{
+  fprintf(2, "bench_scale: %s failed\n", what);
+  exit(1);
+}
+
+/**
+ * 工作进程主体：跑满 duration，返回完成的操作数
+ * @param mix 负载名
+ * @param id  工作进程序号，用来区分各自的文件
+ */
+static uint64
+work(char *mix, int id)
+{
+  static char buf[BSIZE];
+  uint64 end = rdtime() + duration;
+  uint64 ops = 0, x = id + 1;
+  char name[16];
+  int fd, ping[2], pong[2], pid = -1;
+  char c = 0;
+
+  if(strcmp(mix, "pipe") == 0){
+    if(pipe(ping) < 0 || pipe(pong) < 0)
+      die("pipe");
+    if((pid = fork()) < 0)
+      die("fork");
+    if(pid == 0){
+      close(ping[1]);
+      close(pong[0]);
+      while(read(ping[0], &c, 1) == 1)
+        write(pong[1], &c, 1);
+      exit(0);
+    }
+    close(ping[0]);
+    close(pong[1]);
+  }
+  strcpy(name, "scale.w");
+  name[7] = 'a' + id;
+  name[8] = 0;
+
+  while(rdtime() < end){
+    if(strcmp(mix, "cpu") == 0){
+      x = cpu_op(x);
+    } else if(strcmp(mix, "alloc") == 0){
+      char *p = sbrklazy(ALLOCPAGES * PGSIZE);
+      if(p == SBRK_ERROR)
+        die("sbrklazy");
+      for(int i = 0; i < ALLOCPAGES; i++)
+        p[i * PGSIZE] = 1;
+      sbrk(-ALLOCPAGES * PGSIZE);
+    } else if(strcmp(mix, "file") == 0){
+      if((fd = open(name, O_CREATE | O_WRONLY)) < 0)
+        die("create");
+      write(fd, &c, 1);
+      close(fd);
+      if(unlink(name) < 0)
+        die("unlink");
+    } else if(strcmp(mix, "pipe") == 0){
+      if(write(ping[1], &c, 1) != 1 || read(pong[0], &c, 1) != 1)
+        die("pipe");
+    } else if(strcmp(mix, "bcache") == 0){
+      if((fd = open(SHARED, O_RDONLY)) < 0)
+        die("open");
+      while(read(fd, buf, BSIZE) == BSIZE)
+        ops++;
+      close(fd);
+      continue;
+    }
+    ops++;
+  }
+
+  if(pid > 0){
+    close(ping[1]);
+    close(pong[0]);
+    wait(0);
+  }
+  return ops + (x == 0);        // 用掉 x，防止 cpu 负载被优化掉
+}
+
+/**
+ * 用 n 个工作进程跑一次负载，返回总操作数
+ */
+static uint64
+run(char *mix, int n)
+{
+  int go[2], res[2], i, pid;
+  uint64 ops, total = 0;
+  char c;
+
+  if(pipe(go) < 0 || pipe(res) < 0)
+    die("pipe");
+  for(i = 0; i < n; i++){
+    if((pid = fork()) < 0)
+      die("fork");
+    if(pid == 0){
+      close(go[1]);
+      close(res[0]);
+      read(go[0], &c, 1);       // 等父进程关闭写端
+      ops = work(mix, i);
+      write(res[1], &ops, sizeof(ops));
+      exit(0);
+    }
+  }
+  close(go[0]);
+  close(res[1]);
+  close(go[1]);                 // 同时放行所有工作进程
+
+  for(i = 0; i < n; i++){
+    if(read(res[0], &ops, sizeof(ops)) != sizeof(ops))
+      die("result");
+    total += ops;
+  }
+  close(res[0]);
+  for(i = 0; i < n; i++)
+    wait(0);
+  return total;
+}
+
+// 准备 bcache 负载读的共享文件
+static void
+mkshared(void)
+{
+  static char buf[BSIZE];
+  int fd;
+
+  if((fd = open(SHARED, O_CREATE | O_TRUNC | O_WRONLY)) < 0)
+    die("create");
+  for(int i = 0; i < SHAREDBLKS; i++)
+    if(write(fd, buf, BSIZE) != BSIZE)
+      die("write");
+  close(fd);
+}
+
+static void
+usage(void)
+{
+  fprintf(2, "usage: bench_scale [-t ms] [-n workers]... [mix...]\n");
+  exit(1);
+}
+
+int
+main(int argc, char *argv[])
+{
+  static char *mixes[] = { "cpu", "alloc", "file", "pipe", "bcache" };
+  int workers[MAXWORKERS], nw = 0;
+  int ms = 2000;
+  struct clockinfo ci;
+  int i, m, w, any;
+
+  for(i = 1; i < argc && argv[i][0] == '-'; i++){
+    if(strcmp(argv[i], "-t") == 0 && i + 1 < argc)
+      ms = atoi(argv[++i]);
+    else if(strcmp(argv[i], "-n") == 0 && i + 1 < argc && nw < MAXWORKERS)
+      workers[nw++] = atoi(argv[++i]);
+    else
+      usage();
+  }
+  if(nw == 0){
+    workers[nw++] = 1;
+    workers[nw++] = 2;
+    workers[nw++] = 4;
+    workers[nw++] = 8;
+  }
+  for(w = 0; w < nw; w++)
+    if(workers[w] <= 0 || workers[w] > 26)
+      usage();
+  if(ms <= 0)
+    usage();
+
+  if(clockinfo(&ci) < 0 || ci.time_freq == 0)
+    die("clockinfo");
+  time_freq = ci.time_freq;
+  duration = time_freq * ms / 1000;
+  mkshared();
+
+  for(m = 0; m < sizeof(mixes) / sizeof(mixes[0]); m++){
+    any = i >= argc;
+    for(int j = i; j < argc; j++)
+      if(strcmp(argv[j], mixes[m]) == 0)
+        any = 1;
+    if(!any)
+      continue;
+
+    uint64 base = 0;
+    for(w = 0; w < nw; w++){
+      uint64 ops = run(mixes[m], workers[w]);
+      uint64 rate = ops * 1000 / ms;
+      // 第一个点作为基准，默认就是 1 个工作进程
+      if(w == 0)
+        base = rate ? rate : 1;
+      uint64 sp = rate * 100 / base;
+      printf("[%s-%dworkers] workers=%d ms=%d ops=%lu ops_per_s=%lu speedup=%lu.%02lu\n",
+             mixes[m], workers[w], workers[w], ms, ops, rate, sp / 100, sp % 100);
+    }
+  }
+  unlink(SHARED);
+  exit(0);
+}
@@ -0,0 +1,93 @@
+
+// user/dmesg.c - 打印内核日志
+
+//
+// 用法：
+//   dmesg [-l level]   只显示级别不高于 level 的记录（默认全部）
+//
+// 输出格式：
+//   [秒.微秒] cpuN L 正文
+//   L 为级别缩写：E(emerg) R(err) W(warn) I(info) D(debug)
+//
+// 各 CPU 的记录按时间戳归并；一条 printf 可能拆成多条记录，
+// 它们时间戳相同，稳定排序后仍然相邻；只在行首打印前缀
+//
+
+#include "kernel/types.h"
+#include "kernel/klog.h"
+#include "kernel/clock.h"
+#include "user/user.h"
+
+#define MAXENT (KLOG_NENT * 8)
+
+static struct klogent ents[MAXENT];
+
+static char
+levelchar(int level)
+{
+  switch(level){
+  case KLOG_EMERG: return 'E';
+  case KLOG_ERR:   return 'R';
+  case KLOG_WARN:  return 'W';
+  case KLOG_INFO:  return 'I';
+  case KLOG_DEBUG: return 'D';
+  }
+  return '?';
+}
+
+int
+main(int argc, char *argv[])
+{
+  int maxlevel = KLOG_DEBUG;
+  struct clockinfo ci;
+  uint64 freq = 10000000;
+  int n, bol = 1;
+
+  if(argc == 3 && strcmp(argv[1], "-l") == 0){
+    maxlevel = atoi(argv[2]);
+  } else if(argc != 1){
+    fprintf(2, "usage: dmesg [-l level]\n");
+    exit(1);
+  }
+  if(clockinfo(&ci) == 0 && ci.time_freq > 0)
+    freq = ci.time_freq;
+
+  if((n = dmesg(ents, MAXENT)) < 0){
+    fprintf(2, "dmesg: read failed\n");
+    exit(1);
+  }
+
+  // 按时间戳排序（插入排序，各 CPU 组内已有序）
+  for(int i = 1; i < n; i++){
+    struct klogent e = ents[i];
+    int j = i - 1;
+    while(j >= 0 && ents[j].ts > e.ts){
+      ents[j+1] = ents[j];
+      j--;
+    }
+    ents[j+1] = e;
+  }
+
+  for(int i = 0; i < n; i++){
+    struct klogent *e = &ents[i];
+    if(e->level > maxlevel)
+      continue;
+    for(int k = 0; k < e->len; k++){
+      if(bol){
+        uint64 us = e->ts * 1000000 / freq;
+        printf("[%lu.", us / 1000000);
+        // 微秒补足 6 位（printf 不支持宽度）
+        for(uint64 d = 100000; d > 1 && us % 1000000 < d; d /= 10)
+          printf("0");
+        printf("%lu] cpu%d %c ", us % 1000000, e->cpu, levelchar(e->level));
+        bol = 0;
+      }
+      fputc(1, e->text[k]);
+      if(e->text[k] == '\n')
+        bol = 1;
+    }
+  }
+  if(!bol)
+    printf("\n");
+  exit(0);
+}
@@ -0,0 +1,81 @@
+
+// user/faults.c - 页错误统计工具
+
+//
+// 用法：
+//   faults              打印启动以来的全局页错误统计
+//   faults cmd [args]   运行 cmd，打印它运行期间的全局统计增量
+//
+// 输出格式（key=value）：
+//   [faults] type=T count=N total_cycles=C cycles_per_fault=A
+//   [hist] type=T 512=N 1024=N ...    （键是桶的上界，单位 cycle，
+//                                       只列非零的桶，最后一桶是 inf）
+//
+
+#include "kernel/types.h"
+#include "kernel/param.h"
+#include "kernel/faultstat.h"
+#include "user/user.h"
+
+static char *faultname[NFAULTTYPE] = {
+  [FAULT_COW_COPY]  "cow_copy",
+  [FAULT_COW_REUSE] "cow_reuse",
+  [FAULT_LAZY]      "lazy",
+  [FAULT_SPURIOUS]  "spurious",
+};
+
+static struct faultstat before, after;
+
+static void
+print(struct faultstat *a, struct faultstat *b)
+{
+  for(int t = 0; t < NFAULTTYPE; t++){
+    uint64 n = b->count[t] - a->count[t];
+    uint64 c = b->cycles[t] - a->cycles[t];
+    printf("[faults] type=%s count=%lu total_cycles=%lu cycles_per_fault=%lu\n",
+           faultname[t], n, c, n ? c / n : 0);
+    if(n == 0)
+      continue;
+    printf("[hist] type=%s", faultname[t]);
+    for(int i = 0; i < FAULT_NBUCKET; i++){
+      uint64 h = b->hist[t][i] - a->hist[t][i];
+      if(h == 0)
+        continue;
+      if(i == FAULT_NBUCKET - 1)
+        printf(" inf=%lu", h);
+      else
+        printf(" %lu=%lu", 1UL << (i + FAULT_HISTSHIFT + 1), h);
+    }
+    printf("\n");
+  }
+}
+
+int
+main(int argc, char *argv[])
+{
+  int pid;
+
+  if(faultstat(FAULTSTAT_ALL, &before) < 0){
+    fprintf(2, "faults: faultstat failed\n");
+    exit(1);
+  }
+  if(argc < 2){
+    memset(&after, 0, sizeof(after));
+    print(&after, &before);
+    exit(0);
+  }
+
+  if((pid = fork()) < 0){
+    fprintf(2, "faults: fork failed\n");
+    exit(1);
+  }
+  if(pid == 0){
+    exec(argv[1], argv + 1);
+    fprintf(2, "faults: exec %s failed\n", argv[1]);
+    exit(1);
+  }
+  wait(0);
+  faultstat(FAULTSTAT_ALL, &after);
+  print(&before, &after);
+  exit(0);
+}
@@ -0,0 +1,172 @@
+
+// user/fdtable_test.c - 进程文件描述符表测试
+
+//
+// 测试内容：
+// 1. 默认上限为 NOFILE，超出时 dup 失败且 errno 为 EMFILE
+// 2. fdlimit 调高上限后可以打开上千个 fd，始终分配最小的空闲 fd
+// 3. fork 出的子进程继承上限和所有打开的 fd
+// 4. 管道数量超过原来的系统文件表大小（100 个 struct file）
+// 5. 打开大量 fd 时 dup+close 的耗时，应与 fd 数量无关
+//
+// 输出格式（key=value）：
+//   [dupclose] open=N pairs=P ns_per_pair=T
+//
+
+#include "kernel/types.h"
+#include "kernel/param.h"
+#include "user/user.h"
+#include "user/errno.h"
+
+#define MANY    2000
+#define NPIPE   200
+#define PAIRS   2000
+
+#define ASSERT(expr) do { \
+  if(!(expr)) { \
+    printf("assert failed: %s at %s:%d\n", #expr, __FILE__, __LINE__); \
+    exit(1); \
+  } \
+} while(0)
+
+/**
+ * 关闭 [from, to) 之间的所有 fd
+ */
+static void
+closerange(int from, int to)
+{
+  for(int fd = from; fd < to; fd++)
+    close(fd);
+}
+
+/**
+ * dup 直到失败，返回最后一个成功的 fd
+ */
+static int
+dupall(void)
+{
+  int fd, last = -1;
+
+  while((fd = dup(0)) >= 0)
+    last = fd;
+  return last;
+}
+
+/**
+ * 测试 1: 默认上限
+ */
+static void
+test_default_limit(void)
+{
+  int last;
+
+  printf("[fdtable] default limit...\n");
+  ASSERT(fdlimit(0) == NOFILE);
+  last = dupall();
+  ASSERT(last == NOFILE - 1);
+  ASSERT(geterrno() == EMFILE);
+  closerange(3, NOFILE);
+  printf("[fdtable] default limit passed\n");
+}
+
+/**
+ * 测试 2: 调高上限，检查最小空闲 fd 分配
+ */
+static void
+test_many(void)
+{
+  printf("[fdtable] %d fds...\n", MANY);
+  ASSERT(fdlimit(MANY) == NOFILE);
+  ASSERT(fdlimit(0) == MANY);
+  ASSERT(dupall() == MANY - 1);
+
+  // 跨页的空洞：504 是每页 fd 数
+  close(700);
+  close(503);
+  close(504);
+  ASSERT(dup(0) == 503);
+  ASSERT(dup(0) == 504);
+  ASSERT(dup(0) == 700);
+  ASSERT(dup(0) < 0);
+
+  ASSERT(fdlimit(MANY * 100) < 0);
+  ASSERT(fdlimit(-1) < 0);
+  printf("[fdtable] %d fds passed\n", MANY);
+}
+
+/**
+ * 测试 3: fork 继承上限和 fd
+ */
+static void
+test_fork(void)
+{
+  int pid, status;
+
+  printf("[fdtable] fork...\n");
+  pid = fork();
+  ASSERT(pid >= 0);
+  if(pid == 0){
+    if(fdlimit(0) != MANY || write(MANY - 1, "", 0) != 0)
+      exit(1);
+    closerange(3, MANY);
+    exit(0);
+  }
+  wait(&status);
+  ASSERT(status == 0);
+  ASSERT(write(MANY - 1, "", 0) == 0);   // 子进程关闭不影响父进程
+  closerange(3, MANY);
+  printf("[fdtable] fork passed\n");
+}
+
+/**
+ * 测试 4: 大量管道
+ */
+static void
+test_pipes(void)
+{
+  int p[2], i;
+  char c;
+
+  printf("[fdtable] %d pipes...\n", NPIPE);
+  for(i = 0; i < NPIPE; i++)
+    ASSERT(pipe(p) == 0);
+  ASSERT(p[1] == 3 + 2 * NPIPE - 1);
+  ASSERT(write(p[1], "x", 1) == 1);
+  ASSERT(read(p[0], &c, 1) == 1);
+  closerange(3, 3 + 2 * NPIPE);
+  printf("[fdtable] %d pipes passed\n", NPIPE);
+}
+
+/**
+ * 测试 5: 打开 MANY-1 个 fd 时 dup+close 的耗时
+ */
+static void
+bench_dupclose(void)
+{
+  uint64 t0, t1;
+  int i, fd;
+
+  for(i = 3; i < MANY - 1; i++)
+    dup(0);
+  t0 = nsecs();
+  for(i = 0; i < PAIRS; i++){
+    fd = dup(0);
+    close(fd);
+  }
+  t1 = nsecs();
+  printf("[dupclose] open=%d pairs=%d ns_per_pair=%ld\n",
+         MANY - 1, PAIRS, (t1 - t0) / PAIRS);
+  closerange(3, MANY);
+}
+
+int
+main(int argc, char *argv[])
+{
+  test_default_limit();
+  test_many();
+  test_fork();
+  test_pipes();
+  bench_dupclose();
+  printf("[fdtable] all tests passed\n");
+  exit(0);
+}
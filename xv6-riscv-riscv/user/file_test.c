@@ -23,7 +23,7 @@ static void make_name(const char *prefix, int num, char *out, int outsz) {
   out[i] = '\0';
 }
 
-static inline uint64 get_time(void) { return (uint64)uptime(); }
+static inline uint64 get_time(void) { return nsecs() / 1000; }  // microseconds
 
 static void test_filesystem_integrity(void) {
   printf("[FS] integrity test...\n");
@@ -102,8 +102,8 @@ static void test_filesystem_performance(void) {
   free(buf);
   uint64 large_time = get_time() - start;
 
-  printf("[FS] Small files (%dx4B): %lu ticks\n", created, small_time);
-  printf("[FS] Large file (512KB): %lu ticks\n", large_time);
+  printf("[FS] Small files (%dx4B): %lu us\n", created, small_time);
+  printf("[FS] Large file (512KB): %lu us\n", large_time);
 
   // cleanup
   for (int i = 0; i < created; i++) {
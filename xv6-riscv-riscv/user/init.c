@@ -12,10 +12,86 @@
 // 传入小参数：rounds ops_no ops_small ops_big pages_small pages_big
 char *argv[] = { "bench_cow", "3", "10", "5", "2", "1", "128", 0 };
 
+#define MAXLINE 128
+#define MAXARG  16
+
+// 读一行到 buf，不含换行；返回 0 表示文件结束
+static int
+readline(int fd, char *buf, int n)
+{
+  int i = 0;
+  char c;
+
+  while(read(fd, &c, 1) == 1){
+    if(c == '\n')
+      return 1;
+    if(i < n - 1)
+      buf[i++] = c;
+    buf[i] = 0;
+  }
+  return i > 0;
+}
+
+// runrc - 依次运行 initrc 中的命令，每行一个，参数以空格分隔
+//
+// 文件系统镜像中有 initrc 时（test-xv6.py 的 bench 模式会放进去）
+// 代替默认的 bench_cow。每条命令前后各打印一行标记，
+// 便于主机上的脚本把输出归到对应的命令；不会返回
+//
+static void
+runrc(int fd)
+{
+  char line[MAXLINE], *args[MAXARG + 1], *s;
+  int n, pid, st;
+
+  for(;;){
+    line[0] = 0;
+    if(!readline(fd, line, sizeof(line)))
+      break;
+    // 按空格切分参数
+    n = 0;
+    for(s = line; *s && n < MAXARG; ){
+      while(*s == ' ')
+        *s++ = 0;
+      if(*s == 0)
+        break;
+      args[n++] = s;
+      while(*s && *s != ' ')
+        s++;
+    }
+    args[n] = 0;
+    if(n == 0 || args[0][0] == '#')
+      continue;
+
+    printf("init: run %s\n", args[0]);
+    if((pid = fork()) < 0){
+      printf("init: fork failed\n");
+      exit(1);
+    }
+    if(pid == 0){
+      exec(args[0], args);
+      printf("init: exec %s failed\n", args[0]);
+      exit(1);
+    }
+    while(wait(&st) != pid)
+      ;
+    printf("init: done %s status=%d\n", args[0], st);
+  }
+  printf("init: initrc completed\n");
+
+  // init 不能退出（内核会 panic），继续回收孤儿进程，
+  // 由主机上的脚本在看到上面的标记后关掉 QEMU。
+  // 没有子进程时 wait 立即返回 -1，歇一会儿免得空转
+  close(fd);
+  for(;;)
+    if(wait(0) < 0)
+      pause(10);
+}
+
 int
 main(void)
 {
-  int pid, wpid;
+  int pid, wpid, fd;
 
   if(open("console", O_RDWR) < 0){
     mknod("console", CONSOLE, 0);
@@ -24,6 +100,8 @@ main(void)
   dup(0);  // stdout
   dup(0);  // stderr
 
+  if((fd = open("initrc", O_RDONLY)) >= 0)
+    runrc(fd);
 
   pid = fork();
   if(pid < 0){
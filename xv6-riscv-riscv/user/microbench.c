@@ -0,0 +1,289 @@
+
+// user/microbench.c - 内核基本原语的微基准测试
+
+//
+// 用法：
+//   microbench [-n iters] [name...]   默认运行全部场景，每个 iters 次（默认 1000）
+//
+// 测试场景（name）：
+//   getpid         空系统调用：陷入、分发、返回
+//   pipe_pingpong  两个进程经两根管道互相传 1 字节，一次往返包含两次切换
+//   yield          yield() 往返：进入调度器再被选中
+//   pagefault      惰性分配的页第一次写入：缺页、kalloc、清零、映射
+//   fork_exit      fork + 子进程 exit + wait
+//   exec           fork + 子进程 exec 本程序（-x，立即退出）+ wait
+//   sbrk_eager     sbrk 急切分配 SBRKPAGES 页并逐页写一次，按页计
+//   sbrk_lazy      sbrklazy 分配同样多的页并逐页写一次，按页计
+//
+// 计时：
+// - 用 rdtime 读 time 计数器，它在各 CPU 之间同步，
+//   测量期间进程换了 CPU 也不影响结果
+// - 单次开销远小于计数器分辨率的场景，每个样本连续做 batch 次取平均
+// - 正式计时前先做 WARMUP 次，让缓存（proc、页表、块缓存）进入稳态
+//
+// 可以在不同 CPUS 下分别运行（make CPUS=n qemu），
+// test-xv6.py 的 bench 模式按同样的格式解析
+//
+// 输出格式（key=value，每个场景一行，单位 ns/op）：
+//   [microbench] iters=N time_freq=F
+//   [getpid] iters=N batch=B mean_ns=M p50_ns=P p99_ns=Q min_ns=L
+//
+
+#include "kernel/types.h"
+#include "kernel/riscv.h"
+#include "kernel/clock.h"
+#include "user/user.h"
+
+#define MAXITERS   4000
+#define WARMUP     10
+#define SLOWITERS  200          // fork/exec 这类慢场景的次数上限
+#define SBRKPAGES  16
+
+static uint64 samp[MAXITERS];   // 每个样本的 time 计数
+static int iters = 1000;
+static uint64 time_freq;
+static char *self;
+
+// 样本从小到大排序（希尔排序）
+static void
+sort(uint64 *a, int n)
+{
+  for(int gap = n / 2; gap > 0; gap /= 2){
+    for(int i = gap; i < n; i++){
+      uint64 v = a[i];
+      int j;
+      for(j = i; j >= gap && a[j - gap] > v; j -= gap)
+        a[j] = a[j - gap];
+      a[j] = v;
+    }
+  }
+}
+
+// time 计数换算成纳秒，再除以每个样本包含的操作数
+static uint64
+ns(uint64 t, int batch)
+{
+  return t * 1000000000UL / time_freq / batch;
+}
+
+/**
+ * 打印 n 个样本的统计
+ * @param name  场景名
+ * @param n     样本数
+ * @param batch 每个样本包含的操作数
+ */
+static void
+report(char *name, int n, int batch)
+{
+  uint64 sum = 0;
+
+  for(int i = 0; i < n; i++)
+    sum += samp[i];
+  sort(samp, n);
+  printf("[%s] iters=%d batch=%d mean_ns=%lu p50_ns=%lu p99_ns=%lu min_ns=%lu\n",
+         name, n, batch, ns(sum / n, batch), ns(samp[n / 2], batch),
+         ns(samp[n * 99 / 100], batch), ns(samp[0], batch));
+}
+
+static void
+die(char *what)
+{
+  fprintf(2, "microbench: %s failed\n", what);
+  exit(1);
+}
+
+static void
+bench_getpid(void)
+{
+  int batch = 64;
+
+  for(int i = -WARMUP; i < iters; i++){
+    uint64 t0 = rdtime();
+    for(int j = 0; j < batch; j++)
+      getpid();
+    if(i >= 0)
+      samp[i] = rdtime() - t0;
+  }
+  report("getpid", iters, batch);
+}
+
+static void
+bench_pipe(void)
+{
+  int ping[2], pong[2], pid;
+  char c = 0;
+
+  if(pipe(ping) < 0 || pipe(pong) < 0)
+    die("pipe");
+  if((pid = fork()) < 0)
+    die("fork");
+  if(pid == 0){
+    close(ping[1]);
+    close(pong[0]);
+    while(read(ping[0], &c, 1) == 1)
+      write(pong[1], &c, 1);
+    exit(0);
+  }
+  close(ping[0]);
+  close(pong[1]);
+
+  for(int i = -WARMUP; i < iters; i++){
+    uint64 t0 = rdtime();
+    if(write(ping[1], &c, 1) != 1 || read(pong[0], &c, 1) != 1)
+      die("pipe_pingpong");
+    if(i >= 0)
+      samp[i] = rdtime() - t0;
+  }
+  close(ping[1]);
+  close(pong[0]);
+  wait(0);
+  report("pipe_pingpong", iters, 1);
+}
+
+static void
+bench_yield(void)
+{
+  int batch = 16;
+
+  for(int i = -WARMUP; i < iters; i++){
+    uint64 t0 = rdtime();
+    for(int j = 0; j < batch; j++)
+      yield();
+    if(i >= 0)
+      samp[i] = rdtime() - t0;
+  }
+  report("yield", iters, batch);
+}
+
+static void
+bench_fault(void)
+{
+  char *p;
+
+  if((p = sbrklazy((iters + WARMUP) * PGSIZE)) == SBRK_ERROR)
+    die("sbrklazy");
+  for(int i = -WARMUP; i < iters; i++){
+    char *a = p + (i + WARMUP) * PGSIZE;
+    uint64 t0 = rdtime();
+    *a = 1;
+    if(i >= 0)
+      samp[i] = rdtime() - t0;
+  }
+  sbrk(-(iters + WARMUP) * PGSIZE);
+  report("pagefault", iters, 1);
+}
+
+/**
+ * fork_exit / exec 场景
+ * @param doexec 子进程是否 exec
+ */
+static void
+bench_fork(int doexec)
+{
+  int n = iters < SLOWITERS ? iters : SLOWITERS;
+  int pid;
+
+  for(int i = -WARMUP; i < n; i++){
+    uint64 t0 = rdtime();
+    if((pid = fork()) < 0)
+      die("fork");
+    if(pid == 0){
+      if(doexec){
+        char *argv[] = { self, "-x", 0 };
+        exec(self, argv);
+        die("exec");
+      }
+      exit(0);
+    }
+    wait(0);
+    if(i >= 0)
+      samp[i] = rdtime() - t0;
+  }
+  report(doexec ? "exec" : "fork_exit", n, 1);
+}
+
+/**
+ * sbrk_eager / sbrk_lazy 场景：分配 SBRKPAGES 页、逐页写一次，
+ * 缩回的时间不计入
+ * @param lazy 是否惰性分配
+ */
+static void
+bench_sbrk(int lazy)
+{
+  char *p;
+
+  for(int i = -WARMUP; i < iters; i++){
+    uint64 t0 = rdtime();
+    p = lazy ? sbrklazy(SBRKPAGES * PGSIZE) : sbrk(SBRKPAGES * PGSIZE);
+    if(p == SBRK_ERROR)
+      die("sbrk");
+    for(int j = 0; j < SBRKPAGES; j++)
+      p[j * PGSIZE] = 1;
+    if(i >= 0)
+      samp[i] = rdtime() - t0;
+    sbrk(-SBRKPAGES * PGSIZE);
+  }
+  report(lazy ? "sbrk_lazy" : "sbrk_eager", iters, SBRKPAGES);
+}
+
+static void bench_fork_exit(void) { bench_fork(0); }
+static void bench_exec(void) { bench_fork(1); }
+static void bench_sbrk_eager(void) { bench_sbrk(0); }
+static void bench_sbrk_lazy(void) { bench_sbrk(1); }
+
+static struct {
+  char *name;
+  void (*fn)(void);
+} benches[] = {
+  { "getpid",        bench_getpid },
+  { "pipe_pingpong", bench_pipe },
+  { "yield",         bench_yield },
+  { "pagefault",     bench_fault },
+  { "fork_exit",     bench_fork_exit },
+  { "exec",          bench_exec },
+  { "sbrk_eager",    bench_sbrk_eager },
+  { "sbrk_lazy",     bench_sbrk_lazy },
+};
+#define NBENCH (sizeof(benches) / sizeof(benches[0]))
+
+static void
+usage(void)
+{
+  fprintf(2, "usage: microbench [-n iters] [name...]\n");
+  exit(1);
+}
+
+int
+main(int argc, char *argv[])
+{
+  struct clockinfo ci;
+  int i, b, any;
+
+  self = argv[0];
+  if(argc == 2 && strcmp(argv[1], "-x") == 0)
+    exit(0);                    // exec 场景的目标
+
+  for(i = 1; i < argc && argv[i][0] == '-'; i++){
+    if(strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+      iters = atoi(argv[++i]);
+    else
+      usage();
+  }
+  if(iters <= 0 || iters > MAXITERS)
+    usage();
+
+  if(clockinfo(&ci) < 0 || ci.time_freq == 0)
+    die("clockinfo");
+  time_freq = ci.time_freq;
+  printf("[microbench] iters=%d time_freq=%lu\n", iters, time_freq);
+
+  for(b = 0; b < NBENCH; b++){
+    any = i >= argc;
+    for(int j = i; j < argc; j++)
+      if(strcmp(argv[j], benches[b].name) == 0)
+        any = 1;
+    if(any)
+      benches[b].fn();
+  }
+  exit(0);
+}
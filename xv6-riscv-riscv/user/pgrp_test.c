@@ -0,0 +1,131 @@
+
+// user/pgrp_test.c - 进程组与 killpg 测试
+
+//
+// 测试内容：
+// 1. setpgid/getpgid/setsid 的基本语义和错误返回
+// 2. 建立一个 NCHILD 个进程的工作组，一半阻塞在管道读上，
+//    一半在 pause() 中长时间睡眠
+// 3. 一次 killpg 拆除整个组，睡眠中的成员应被立即唤醒，
+//    全部回收的时间远小于它们的睡眠时间
+// 4. 对照：同样规模的组逐个 kill
+//
+// 输出格式（key=value）：
+//   [killpg] n=N ns_call=T ns_teardown=T
+//   [kill] n=N ns_call=T ns_teardown=T
+//
+
+#include "kernel/types.h"
+#include "user/user.h"
+
+#define NCHILD  400
+#define LONG    100000          // 睡眠 tick 数，远超测试时长
+
+#define ASSERT(expr) do { \
+  if(!(expr)) { \
+    printf("assert failed: %s at %s:%d\n", #expr, __FILE__, __LINE__); \
+    exit(1); \
+  } \
+} while(0)
+
+static int pids[NCHILD];
+static int fds[2];
+
+// 工作进程：偶数号阻塞在管道上，奇数号在 pause() 中睡眠
+static void
+worker(int i)
+{
+  char c;
+
+  if(i % 2 == 0){
+    close(fds[1]);
+    read(fds[0], &c, 1);
+  } else {
+    pause(LONG);
+  }
+  exit(0);
+}
+
+// 创建 NCHILD 个工作进程，都放进以第一个进程为组长的新进程组
+static int
+spawn(void)
+{
+  int i, pid, pgid = 0;
+
+  for(i = 0; i < NCHILD; i++){
+    if((pid = fork()) < 0){
+      printf("[pgrp] fork failed at %d\n", i);
+      exit(1);
+    }
+    if(pid == 0)
+      worker(i);
+    if(i == 0)
+      pgid = pid;
+    ASSERT(setpgid(pid, pgid) == 0);
+    pids[i] = pid;
+  }
+  return pgid;
+}
+
+// 回收 NCHILD 个子进程
+static void
+reap(void)
+{
+  for(int i = 0; i < NCHILD; i++)
+    ASSERT(wait(0) > 0);
+}
+
+int
+main(int argc, char *argv[])
+{
+  int i, pid, pgid, st;
+  uint64 t0, t1, t2;
+
+  // 1. 基本语义
+  pgid = getpgid(0);
+  ASSERT(pgid > 0);
+  ASSERT(getpgid(getpid()) == pgid);
+  ASSERT(getpgid(1) > 0);
+  ASSERT(setpgid(1, 0) < 0);            // 不是子进程
+  ASSERT(setpgid(0, -1) < 0);
+  ASSERT(killpg(-1) < 0);
+
+  if((pid = fork()) == 0){
+    // 子进程继承进程组，不是组长，可以新建会话
+    ASSERT(getpgid(0) == pgid);
+    ASSERT(setsid() == getpid());
+    ASSERT(getpgid(0) == getpid());
+    ASSERT(setsid() < 0);               // 已经是组长
+    exit(0);
+  }
+  ASSERT(wait(&st) == pid && st == 0);
+  ASSERT(killpg(pid) < 0);              // 组随唯一的成员一起消失
+
+  ASSERT(pipe(fds) == 0);
+
+  // 2-3. 一次 killpg 拆除整个组
+  pgid = spawn();
+  ASSERT(getpgid(pids[NCHILD - 1]) == pgid);
+  ASSERT(getpgid(0) != pgid);
+  t0 = nsecs();
+  ASSERT(killpg(pgid) == 0);
+  t1 = nsecs();
+  reap();
+  t2 = nsecs();
+  printf("[killpg] n=%d ns_call=%ld ns_teardown=%ld\n", NCHILD, t1 - t0, t2 - t0);
+  ASSERT(killpg(pgid) < 0);             // 成员都已退出
+
+  // 4. 对照：逐个 kill
+  spawn();
+  t0 = nsecs();
+  for(i = 0; i < NCHILD; i++)
+    ASSERT(kill(pids[i]) == 0);
+  t1 = nsecs();
+  reap();
+  t2 = nsecs();
+  printf("[kill] n=%d ns_call=%ld ns_teardown=%ld\n", NCHILD, t1 - t0, t2 - t0);
+
+  ASSERT(wait(0) < 0);
+  printf("[pgrp] all tests passed\n");
+  exit(0);
+}
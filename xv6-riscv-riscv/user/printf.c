@@ -1,15 +1,133 @@
 #include "kernel/types.h"
 #include "kernel/stat.h"
+#include "kernel/param.h"
 #include "user/user.h"
 
 #include <stdarg.h>
 
 static char digits[] = "0123456789ABCDEF";
 
+// Output buffering. Each fd below NOFILE gets a buffer the
+// first time it is printed to: line buffered if it is the
+// console, fully buffered for files and pipes. fd 2 is
+// unbuffered, but a single printf call still goes out in
+// one write(). ulib.c flushes through stdio_flush before
+// fork, exec, close and exit.
+#define BUFSIZ 512
+
+struct stream {
+  char used;        // mode chosen?
+  char mode;        // _IOFBF, _IOLBF or _IONBF
+  char nl;          // buffer holds a '\n'
+  int n;            // bytes in buf
+  char buf[BUFSIZ];
+};
+
+static struct stream streams[NOFILE];
+
+static void
+flush(int fd, struct stream *s)
+{
+  if(s->n > 0)
+    write(fd, s->buf, s->n);
+  s->n = 0;
+  s->nl = 0;
+}
+
+static void
+flushhook(int fd)
+{
+  if(fd < 0){
+    fflush(-1);
+  } else if(fd < NOFILE){
+    flush(fd, &streams[fd]);
+    streams[fd].used = 0;
+  }
+}
+
+static struct stream*
+getstream(int fd)
+{
+  struct stream *s;
+  struct stat st;
+
+  if(fd < 0 || fd >= NOFILE)
+    return 0;
+  s = &streams[fd];
+  if(!s->used){
+    if(fd == 2 || fstat(fd, &st) < 0)
+      s->mode = _IONBF;
+    else if(st.type == T_DEVICE)
+      s->mode = _IOLBF;
+    else
+      s->mode = _IOFBF;
+    s->used = 1;
+    stdio_flush = flushhook;
+  }
+  return s;
+}
+
+// called at the end of each printf: write out what the
+// stream's mode says should not wait any longer.
+static void
+endcall(int fd)
+{
+  struct stream *s = getstream(fd);
+
+  if(s && (s->mode == _IONBF || (s->mode == _IOLBF && s->nl)))
+    flush(fd, s);
+}
+
 static void
 putc(int fd, char c)
 {
-  write(fd, &c, 1);
+  struct stream *s = getstream(fd);
+
+  if(s == 0){
+    write(fd, &c, 1);
+    return;
+  }
+  s->buf[s->n++] = c;
+  if(c == '\n')
+    s->nl = 1;
+  if(s->n == BUFSIZ)
+    flush(fd, s);
+}
+
+void
+fputc(int fd, char c)
+{
+  putc(fd, c);
+  endcall(fd);
+}
+
+// write out fd's buffered output; fd < 0 means all fds.
+int
+fflush(int fd)
+{
+  if(fd < 0){
+    for(fd = 0; fd < NOFILE; fd++)
+      if(streams[fd].used)
+        flush(fd, &streams[fd]);
+    return 0;
+  }
+  if(fd >= NOFILE)
+    return 0;
+  flush(fd, &streams[fd]);
+  return 0;
+}
+
+// choose fd's buffering mode (_IOFBF, _IOLBF or _IONBF).
+int
+setvbuf(int fd, int mode)
+{
+  struct stream *s = getstream(fd);
+
+  if(s == 0 || mode < _IOFBF || mode > _IONBF)
+    return -1;
+  flush(fd, s);
+  s->mode = mode;
+  return 0;
 }
 
 static void
@@ -120,6 +238,7 @@ fprintf(int fd, const char *fmt, ...)
 
   va_start(ap, fmt);
   vprintf(fd, fmt, ap);
+  endcall(fd);
 }
 
 void
@@ -129,4 +248,5 @@ printf(const char *fmt, ...)
 
   va_start(ap, fmt);
   vprintf(1, fmt, ap);
+  endcall(1);
 }
@@ -82,16 +82,16 @@ test_priority_scheduling(void)
              getpid(), my_priority);
       
       // 执行工作
-      uint64 start = uptime();
+      uint64 start = nsecs();
       for(int j = 0; j < 10; j++) {
         do_work(100000);
         printf("[PID %d] Priority %d: Progress %d/10\n", 
                getpid(), my_priority, j + 1);
       }
-      uint64 end = uptime();
+      uint64 end = nsecs();
       
-      printf("[PID %d] Priority %d: Completed in %d ticks\n", 
-             getpid(), my_priority, (int)(end - start));
+      printf("[PID %d] Priority %d: Completed in %lu us\n", 
+             getpid(), my_priority, (end - start) / 1000);
       exit(0);
     }
   }
@@ -0,0 +1,83 @@
+
+// user/proctab_test.c - 动态进程表测试
+
+//
+// 测试内容：
+// 1. 创建 NCHILD 个同时存活的子进程（超过原来固定的 64 项进程表）
+// 2. 分段记录 fork 耗时：进程表变大后 fork 不应变慢
+// 3. 按 pid 调 setpriority/getpriority/kill，查找走 pid 哈希表
+// 4. 子进程全部退出后逐个 wait，回收数与创建数一致
+//
+// 输出格式（key=value）：
+//   [fork] live=N ns_per_fork=T
+//   [kill] live=N ns_per_kill=T
+//
+
+#include "kernel/types.h"
+#include "user/user.h"
+
+#define NCHILD  1000
+#define STEP    200
+
+#define ASSERT(expr) do { \
+  if(!(expr)) { \
+    printf("assert failed: %s at %s:%d\n", #expr, __FILE__, __LINE__); \
+    exit(1); \
+  } \
+} while(0)
+
+static int pids[NCHILD];
+
+int
+main(int argc, char *argv[])
+{
+  int fds[2], i, n, pid;
+  uint64 t0, t1;
+  char c;
+
+  ASSERT(pipe(fds) == 0);
+
+  // 1-2. 子进程阻塞在管道上，直到父进程关闭写端
+  printf("[proctab] forking %d children...\n", NCHILD);
+  for(n = 0; n < NCHILD; n += STEP){
+    t0 = nsecs();
+    for(i = n; i < n + STEP; i++){
+      if((pid = fork()) < 0){
+        printf("[proctab] fork failed at %d\n", i);
+        exit(1);
+      }
+      if(pid == 0){
+        close(fds[1]);
+        read(fds[0], &c, 1);
+        exit(0);
+      }
+      pids[i] = pid;
+    }
+    t1 = nsecs();
+    printf("[fork] live=%d ns_per_fork=%ld\n", n + STEP, (t1 - t0) / STEP);
+  }
+
+  // 3. 按 pid 查找：最早和最晚创建的子进程
+  ASSERT(setpriority(pids[0], 3) == 0);
+  ASSERT(getpriority(pids[0]) == 3);
+  ASSERT(setpriority(pids[NCHILD - 1], 7) == 0);
+  ASSERT(getpriority(pids[NCHILD - 1]) == 7);
+  ASSERT(getpriority(pids[NCHILD - 1] + 1000) < 0);
+
+  t0 = nsecs();
+  for(i = 0; i < STEP; i++)
+    ASSERT(kill(pids[i]) == 0);
+  t1 = nsecs();
+  printf("[kill] live=%d ns_per_kill=%ld\n", NCHILD, (t1 - t0) / STEP);
+
+  // 4. 放行其余子进程，全部回收
+  close(fds[0]);
+  close(fds[1]);
+  for(i = 0; i < NCHILD; i++)
+    ASSERT(wait(0) > 0);
+  ASSERT(wait(0) < 0);
+  ASSERT(kill(pids[0]) < 0);      // 已回收，pid 不再存在
+
+  printf("[proctab] all tests passed\n");
+  exit(0);
+}
@@ -0,0 +1,160 @@
+
+// user/prof.c - 采样剖析工具
+
+//
+// 用法：
+//   prof [-f hz] cmd [args...]   运行 cmd，期间对所有 CPU 采样
+//
+// 选项：
+//   -f hz  每个 CPU 每秒的采样数，默认 1000
+//
+// 工作流程：
+//   1. prof(hz) 开启采样
+//   2. fork 一个读出进程，每个 tick 把内核采样环读到内存中，
+//      避免 cmd 运行较久时环被覆盖
+//   3. fork 子进程 exec 目标程序，等它退出后 prof(0) 关闭采样
+//   4. 读出进程发现采样已关闭，读完剩余记录后统一打印，
+//      打印本身不会出现在采样中
+//
+// 输出格式（key=value，由主机上的 prof2folded.py 符号化）：
+//   [sample] cpu=C pid=P user=U name=N pc=0x... stack=0x...,0x...
+//   [prof] hz=H samples=S lost=L user=U kernel=K idle=I
+//
+
+#include "kernel/types.h"
+#include "kernel/prof.h"
+#include "user/user.h"
+
+#define MAXSAMP 16384
+#define CHUNK   64
+
+static struct profent *samp;
+static int nsamp;
+static uint64 nlost;
+
+// 读出内核中所有记录，追加到 samp[]；缓冲区满时后续记录计入丢失
+static void
+drain(void)
+{
+  static struct profent tmp[CHUNK];
+  uint64 lost;
+  int n;
+
+  for(;;){
+    lost = 0;             // 调用失败时内核不会写 lost
+    if((n = profread(tmp, CHUNK, &lost)) < 0){
+      fprintf(2, "prof: profread failed\n");
+      return;
+    }
+    if(n == 0 && lost == 0)
+      break;
+    nlost += lost;
+    for(int i = 0; i < n; i++){
+      if(nsamp < MAXSAMP)
+        samp[nsamp++] = tmp[i];
+      else
+        nlost++;
+    }
+    if(n < CHUNK)
+      break;
+  }
+}
+
+static void
+print_samples(int hz)
+{
+  int nuser = 0, nkernel = 0, nidle = 0;
+
+  for(int i = 0; i < nsamp; i++){
+    struct profent *e = &samp[i];
+    printf("[sample] cpu=%d pid=%d user=%d name=%s pc=0x%lx stack=",
+           e->cpu, e->pid, e->user, e->name, e->pc);
+    for(int j = 0; j < e->depth; j++)
+      printf("%s0x%lx", j ? "," : "", e->stack[j]);
+    printf("\n");
+    if(e->pid == 0)
+      nidle++;
+    else if(e->user)
+      nuser++;
+    else
+      nkernel++;
+  }
+  printf("[prof] hz=%d samples=%d lost=%lu user=%d kernel=%d idle=%d\n",
+         hz, nsamp, nlost, nuser, nkernel, nidle);
+}
+
+// 读出进程：采样开启期间不断读出，关闭后打印全部记录
+static void
+reader(int hz)
+{
+  while(prof(-1) != 0){
+    drain();
+    pause(1);
+  }
+  drain();
+  print_samples(hz);
+  exit(0);
+}
+
+static void
+usage(void)
+{
+  fprintf(2, "usage: prof [-f hz] cmd [args...]\n");
+  exit(1);
+}
+
+int
+main(int argc, char *argv[])
+{
+  int hz = 1000;
+  int i, r, rpid, pid;
+
+  for(i = 1; i < argc && argv[i][0] == '-'; i++){
+    if(strcmp(argv[i], "-f") == 0 && i + 1 < argc)
+      hz = atoi(argv[++i]);
+    else
+      usage();
+  }
+  if(i >= argc || hz <= 0 || hz > PROF_MAXHZ)
+    usage();
+
+  if((samp = malloc(MAXSAMP * sizeof(struct profent))) == 0){
+    fprintf(2, "prof: out of memory\n");
+    exit(1);
+  }
+
+  // 丢弃之前残留的记录
+  drain();
+  nsamp = 0;
+  nlost = 0;
+
+  if(prof(hz) < 0){
+    fprintf(2, "prof: cannot start sampling\n");
+    exit(1);
+  }
+
+  if((rpid = fork()) < 0){
+    prof(0);
+    fprintf(2, "prof: fork failed\n");
+    exit(1);
+  }
+  if(rpid == 0)
+    reader(hz);
+
+  if((pid = fork()) < 0){
+    prof(0);
+    fprintf(2, "prof: fork failed\n");
+    exit(1);
+  }
+  if(pid == 0){
+    exec(argv[i], argv + i);
+    fprintf(2, "prof: exec %s failed\n", argv[i]);
+    exit(1);
+  }
+
+  while((r = wait(0)) != pid && r >= 0)
+    ;
+  prof(0);
+  wait(0);
+  exit(0);
+}
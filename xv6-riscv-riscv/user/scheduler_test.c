@@ -102,7 +102,7 @@ void test_different_schedulers(void) {
     printf("  Scheduler type: %d (%s)\n", scheduler, scheduler_names[scheduler]);
     printf("  Scheduler switched successfully\n");
     
-    int start_time = uptime();
+    uint64 start_time = nsecs();
     
     // 创建多个CPU密集型进程
     printf("  Creating 3 CPU-intensive processes...\n");
@@ -122,9 +122,9 @@ void test_different_schedulers(void) {
       wait(&status);
     }
     
-    int end_time = uptime();
+    uint64 end_time = nsecs();
     printf("  All processes completed\n");
-    printf("  Total time: ~%d ticks\n", end_time - start_time);
+    printf("  Total time: %lu us\n", (end_time - start_time) / 1000);
     
     // 模拟不同调度算法的特点
     switch(scheduler) {
@@ -147,7 +147,7 @@ void test_scheduler(void) {
   
   printf("Creating 3 CPU-intensive processes...\n");
   
-  int start_time = uptime();
+  uint64 start_time = nsecs();
   
   // 创建多个CPU密集型进程
   for(int i = 0; i < 3; i++) {
@@ -164,9 +164,9 @@ void test_scheduler(void) {
     wait(&status);
   }
   
-  int end_time = uptime();
+  uint64 end_time = nsecs();
   printf("  All processes completed\n");
-  printf("  Total time: ~%d ticks\n", end_time - start_time);
+  printf("  Total time: %lu us\n", (end_time - start_time) / 1000);
 }
 
 // 生产者任务
@@ -208,7 +208,7 @@ void test_synchronization(void) {
     return;
   }
   
-  int start_time = uptime();
+  uint64 start_time = nsecs();
   
   // 创建生产者进程
   int pid1 = fork();
@@ -279,11 +279,11 @@ void test_synchronization(void) {
   int first_exit = wait(&status1);
   int second_exit = wait(&status2);
   
-  int end_time = uptime();
+  uint64 end_time = nsecs();
   
   printf("  First process exited: PID=%d\n", first_exit);
   printf("  Second process exited: PID=%d\n", second_exit);
-  printf("  Total time: ~%d ticks\n", end_time - start_time);
+  printf("  Total time: %lu us\n", (end_time - start_time) / 1000);
   printf("  Producer-consumer synchronization test passed!\n");
 }
 
@@ -343,7 +343,7 @@ void test_memory_usage(void) {
 void benchmark_test(void) {
   printf("=== Performance benchmark ===\n");
   
-  int start_time = uptime();
+  uint64 start_time = nsecs();
   
   // 创建多个进程进行基准测试
   int num_processes = 5;
@@ -364,10 +364,10 @@ void benchmark_test(void) {
     wait(0);
   }
   
-  int end_time = uptime();
-  printf("  Benchmark completed in %d ticks\n", end_time - start_time);
-  printf("  Average time per process: %d ticks\n", 
-         (end_time - start_time) / num_processes);
+  uint64 end_time = nsecs();
+  printf("  Benchmark completed in %lu us\n", (end_time - start_time) / 1000);
+  printf("  Average time per process: %lu us\n", 
+         (end_time - start_time) / 1000 / num_processes);
 }
 
 
@@ -0,0 +1,266 @@
+
+// user/strace.c - 系统调用跟踪工具
+
+//
+// 用法：
+//   strace [-m mask] [-q] cmd [args...]   跟踪 cmd 及其子进程
+//   strace -d                              只读出并打印环中已有的记录
+//
+// 选项：
+//   -m mask  64 位跟踪掩码（十进制或 0x 开头的十六进制），
+//            位 (1 << SYS_xxx)；默认跟踪全部
+//   -q       不逐条打印，只输出汇总
+//
+// 工作流程：
+//   1. fork 子进程，子进程 trace(mask) 后 exec 目标程序
+//   2. 子进程退出后读出跟踪环，按开始时间排序
+//   3. 逐条打印并按调用号汇总（长时间运行的程序可用 -q 只看汇总）
+//
+// 汇总行格式（key=value，便于脚本解析）：
+//   [name] calls=N total_ns=T ns_per_call=A errors=E
+//
+
+#include "kernel/types.h"
+#include "kernel/syscall.h"
+#include "kernel/trace.h"
+#include "kernel/clock.h"
+#include "user/user.h"
+
+#define MAXENT 2048
+
+static char *names[] = {
+[SYS_fork]    "fork",
+[SYS_exit]    "exit",
+[SYS_wait]    "wait",
+[SYS_pipe]    "pipe",
+[SYS_read]    "read",
+[SYS_kill]    "kill",
+[SYS_exec]    "exec",
+[SYS_fstat]   "fstat",
+[SYS_chdir]   "chdir",
+[SYS_dup]     "dup",
+[SYS_getpid]  "getpid",
+[SYS_sbrk]    "sbrk",
+[SYS_pause]   "pause",
+[SYS_uptime]  "uptime",
+[SYS_open]    "open",
+[SYS_write]   "write",
+[SYS_mknod]   "mknod",
+[SYS_unlink]  "unlink",
+[SYS_link]    "link",
+[SYS_mkdir]   "mkdir",
+[SYS_close]   "close",
+[SYS_setpriority] "setpriority",
+[SYS_getpriority] "getpriority",
+[SYS_geterrno] "geterrno",
+[SYS_set_scheduler] "set_scheduler",
+[SYS_symlink] "symlink",
+[SYS_readlink] "readlink",
+[SYS_clockinfo] "clockinfo",
+[SYS_syscall_batch] "syscall_batch",
+[SYS_trace]   "trace",
+[SYS_traceread] "traceread",
+[SYS_dmesg]   "dmesg",
+[SYS_fdlimit] "fdlimit",
+[SYS_setpgid] "setpgid",
+[SYS_getpgid] "getpgid",
+[SYS_setsid]  "setsid",
+[SYS_killpg]  "killpg",
+[SYS_prof]    "prof",
+[SYS_profread] "profread",
+[SYS_faultstat] "faultstat",
+[SYS_sysinfo] "sysinfo",
+[SYS_tpctl]   "tpctl",
+[SYS_tpread]  "tpread",
+[SYS_perf_stat] "perf_stat",
+[SYS_yield]   "yield",
+};
+#define NNAMES (sizeof(names) / sizeof(names[0]))
+
+static struct traceent ents[MAXENT];
+static int nent;
+static uint64 nlost;
+static uint64 ns_per_tick = 100;    // 10MHz 时基的默认值，main 中按 clockinfo 修正
+
+static char *
+sysname(int num)
+{
+  if(num > 0 && num < NNAMES && names[num])
+    return names[num];
+  return "?";
+}
+
+// 读出内核中所有记录，追加到 ents[]；缓冲区满时后续记录计入丢失
+static void
+drain(void)
+{
+  static struct traceent tmp[64];
+  uint64 lost;
+  int n;
+
+  for(;;){
+    lost = 0;             // 调用失败时内核不会写 lost
+    if((n = traceread(tmp, 64, &lost)) < 0){
+      fprintf(2, "strace: traceread failed\n");
+      return;
+    }
+    if(n == 0 && lost == 0)
+      break;
+    nlost += lost;
+    for(int i = 0; i < n; i++){
+      if(nent < MAXENT)
+        ents[nent++] = tmp[i];
+      else
+        nlost++;
+    }
+    if(n < 64)
+      break;
+  }
+}
+
+// 按开始时间排序（各 CPU 的记录交错在一起）
+static void
+sort(void)
+{
+  for(int i = 1; i < nent; i++){
+    struct traceent e = ents[i];
+    int j = i - 1;
+    while(j >= 0 && ents[j].start > e.start){
+      ents[j+1] = ents[j];
+      j--;
+    }
+    ents[j+1] = e;
+  }
+}
+
+static void
+print_events(void)
+{
+  for(int i = 0; i < nent; i++){
+    struct traceent *e = &ents[i];
+    printf("%d cpu%d %s(0x%lx, 0x%lx, 0x%lx) = %ld  %lu ns\n",
+           e->pid, e->cpu, sysname(e->num),
+           e->args[0], e->args[1], e->args[2], e->ret,
+           e->dur * ns_per_tick);
+  }
+}
+
+static void
+print_summary(void)
+{
+  uint64 calls[NNAMES], ticks[NNAMES], errs[NNAMES];
+
+  for(int i = 0; i < NNAMES; i++)
+    calls[i] = ticks[i] = errs[i] = 0;
+  for(int i = 0; i < nent; i++){
+    int num = ents[i].num;
+    if(num <= 0 || num >= NNAMES)
+      continue;
+    calls[num]++;
+    ticks[num] += ents[i].dur;
+    if(ents[i].ret < 0)
+      errs[num]++;
+  }
+  printf("--- summary: events=%d lost=%lu\n", nent, nlost);
+  for(int i = 1; i < NNAMES; i++){
+    if(calls[i] == 0)
+      continue;
+    printf("[%s] calls=%lu total_ns=%lu ns_per_call=%lu errors=%lu\n",
+           sysname(i), calls[i], ticks[i] * ns_per_tick,
+           ticks[i] * ns_per_tick / calls[i], errs[i]);
+  }
+}
+
+// 解析 64 位掩码，十进制或 0x 开头的十六进制；格式错误返回 -1
+static int
+parsemask(char *s, uint64 *out)
+{
+  uint64 v = 0;
+  int base = 10, d;
+
+  if(s[0] == '0' && (s[1] == 'x' || s[1] == 'X')){
+    base = 16;
+    s += 2;
+  }
+  if(*s == 0)
+    return -1;
+  for(; *s; s++){
+    if(*s >= '0' && *s <= '9')
+      d = *s - '0';
+    else if(base == 16 && *s >= 'a' && *s <= 'f')
+      d = *s - 'a' + 10;
+    else if(base == 16 && *s >= 'A' && *s <= 'F')
+      d = *s - 'A' + 10;
+    else
+      return -1;
+    v = v * base + d;
+  }
+  *out = v;
+  return 0;
+}
+
+static void
+usage(void)
+{
+  fprintf(2, "usage: strace [-m mask] [-q] cmd [args...]\n");
+  fprintf(2, "       strace -d\n");
+  exit(1);
+}
+
+int
+main(int argc, char *argv[])
+{
+  uint64 mask = TRACE_ALL;
+  int quiet = 0, drainonly = 0;
+  struct clockinfo ci;
+  int i;
+
+  for(i = 1; i < argc && argv[i][0] == '-'; i++){
+    if(strcmp(argv[i], "-m") == 0 && i + 1 < argc){
+      if(parsemask(argv[++i], &mask) < 0)
+        usage();
+    } else if(strcmp(argv[i], "-q") == 0)
+      quiet = 1;
+    else if(strcmp(argv[i], "-d") == 0)
+      drainonly = 1;
+    else
+      usage();
+  }
+  if(!drainonly && i >= argc)
+    usage();
+
+  if(clockinfo(&ci) == 0 && ci.time_freq > 0)
+    ns_per_tick = 1000000000UL / ci.time_freq;
+
+  if(!drainonly){
+    // 丢弃之前残留的记录
+    drain();
+    nent = 0;
+    nlost = 0;
+
+    int pid = fork();
+    if(pid < 0){
+      fprintf(2, "strace: fork failed\n");
+      exit(1);
+    }
+    if(pid == 0){
+      trace(mask);
+      exec(argv[i], &argv[i]);
+      fprintf(2, "strace: exec %s failed\n", argv[i]);
+      exit(1);
+    }
+
+    // xv6 没有非阻塞 wait，子进程退出后再统一读出；
+    // 每个 CPU 的环保存最近 TRACE_NENT 条，更早的计入 lost
+    int status;
+    while(wait(&status) != pid)
+      ;
+  }
+  drain();
+
+  sort();
+  if(!quiet)
+    print_events();
+  print_summary();
+  exit(0);
+}
@@ -62,12 +62,35 @@ static void test_security(void) {
 
 static void test_syscall_performance(void) {
   printf("Testing syscall performance...\n");
-  int start = uptime();
+  uint64 start = nsecs();
+  uint64 c0 = rdcycle();
   for (int i = 0; i < 10000; i++) {
     getpid();
   }
-  int end = uptime();
-  printf("10000 getpid() calls took %d ticks\n", end - start);
+  uint64 c1 = rdcycle();
+  uint64 end = nsecs();
+  printf("10000 getpid() calls took %lu us (%lu ns, %lu cycles per call)\n",
+         (end - start) / 1000, (end - start) / 10000, (c1 - c0) / 10000);
+
+  // open/close: exercises argstr -> copyinstr on the path.
+  // the path is copied from an odd offset to also cover the
+  // unaligned head of the word-at-a-time copy.
+  static char path[32];
+  strcpy(path + 1, "./README");
+  start = nsecs();
+  c0 = rdcycle();
+  for (int i = 0; i < 1000; i++) {
+    int fd = open(path + 1, O_RDONLY);
+    if (fd < 0) {
+      printf("open %s failed\n", path + 1);
+      return;
+    }
+    close(fd);
+  }
+  c1 = rdcycle();
+  end = nsecs();
+  printf("1000 open()+close() pairs took %lu us (%lu ns, %lu cycles per pair)\n",
+         (end - start) / 1000, (end - start) / 1000, (c1 - c0) / 1000);
 }
 
 int main(int argc, char **argv) {
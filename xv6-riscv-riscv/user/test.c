@@ -64,7 +64,7 @@ static void test_scheduler(void) {
   printf("=== Testing scheduler ===\n");
   printf("Creating 3 CPU-intensive processes...\n");
   
-  uint64 t0 = uptime();
+  uint64 t0 = nsecs();
   for (int i = 0; i < 3; i++) {
     int c = fork();
     if (c == 0) cpu_intensive_task();
@@ -72,10 +72,10 @@ static void test_scheduler(void) {
   
   // 等待子进程完成
   for (int i = 0; i < 3; i++) wait(0);
-  uint64 t1 = uptime();
+  uint64 t1 = nsecs();
   
   printf("  All processes completed\n");
-  printf("  Total time: ~%d ticks\n", (int)(t1 - t0));
+  printf("  Total time: %lu us\n", (t1 - t0) / 1000);
 }
 
 static void test_synchronization(void) {
@@ -0,0 +1,173 @@
+
+// user/tpdump.c - 静态跟踪点记录工具
+
+//
+// 用法：
+//   tpdump [-e mask] cmd [args...]   运行 cmd，期间记录内核跟踪点
+//
+// 选项：
+//   -e mask  打开的事件（十进制），位 (1 << TP_xxx)，见 kernel/tracepoint.h；
+//            默认全部
+//
+// 工作流程与 prof 相同：
+//   1. tpctl(mask) 打开跟踪点
+//   2. fork 一个读出进程，每个 tick 把内核环读到内存中
+//   3. fork 子进程 exec 目标程序，等它退出后 tpctl(0) 关闭
+//   4. 读出进程读完剩余记录后统一打印
+//
+// 跟踪点是全系统的，读出进程自己的活动也会出现在记录中。
+//
+// 输出格式（key=value，由主机上的 tp2chrome.py 转成时间线）：
+//   [tp] freq=F                                  time 计数器频率
+//   [tp] t=T cpu=C pid=P ev=NAME a0=0x... a1=0x...
+//   [tpdump] events=N lost=L
+//
+
+#include "kernel/types.h"
+#include "kernel/tracepoint.h"
+#include "kernel/clock.h"
+#include "user/user.h"
+
+#define MAXENT  16384
+#define CHUNK   64
+
+static char *evname[TP_NEVENT] = {
+  [TP_SCHED_IN]      "sched_in",
+  [TP_SCHED_OUT]     "sched_out",
+  [TP_WAKEUP]        "wakeup",
+  [TP_KALLOC]        "kalloc",
+  [TP_KFREE]         "kfree",
+  [TP_BGET_HIT]      "bget_hit",
+  [TP_BGET_MISS]     "bget_miss",
+  [TP_BEGIN_OP]      "begin_op",
+  [TP_BEGIN_OP_DONE] "begin_op_done",
+  [TP_COMMIT]        "commit",
+  [TP_COMMIT_DONE]   "commit_done",
+  [TP_DISK_SUBMIT]   "disk_submit",
+  [TP_DISK_DONE]     "disk_done",
+  [TP_FAULT]         "fault",
+};
+
+static struct tpent *ent;
+static int nent;
+static uint64 nlost;
+
+// 读出内核中所有记录，追加到 ent[]；缓冲区满时后续记录计入丢失
+static void
+drain(void)
+{
+  static struct tpent tmp[CHUNK];
+  uint64 lost;
+  int n;
+
+  for(;;){
+    lost = 0;             // 调用失败时内核不会写 lost
+    if((n = tpread(tmp, CHUNK, &lost)) < 0){
+      fprintf(2, "tpdump: tpread failed\n");
+      return;
+    }
+    if(n == 0 && lost == 0)
+      break;
+    nlost += lost;
+    for(int i = 0; i < n; i++){
+      if(nent < MAXENT)
+        ent[nent++] = tmp[i];
+      else
+        nlost++;
+    }
+    if(n < CHUNK)
+      break;
+  }
+}
+
+static void
+print_events(void)
+{
+  struct clockinfo ci;
+
+  if(clockinfo(&ci) == 0)
+    printf("[tp] freq=%lu\n", ci.time_freq);
+  for(int i = 0; i < nent; i++){
+    struct tpent *e = &ent[i];
+    printf("[tp] t=%lu cpu=%d pid=%d ev=%s a0=0x%lx a1=0x%lx\n",
+           e->time, e->cpu, e->pid,
+           e->ev < TP_NEVENT ? evname[e->ev] : "?", e->arg[0], e->arg[1]);
+  }
+  printf("[tpdump] events=%d lost=%lu\n", nent, nlost);
+}
+
+// 读出进程：跟踪点打开期间不断读出，关闭后打印全部记录
+static void
+reader(void)
+{
+  while(tpctl(-1) != 0){
+    drain();
+    pause(1);
+  }
+  drain();
+  print_events();
+  exit(0);
+}
+
+static void
+usage(void)
+{
+  fprintf(2, "usage: tpdump [-e mask] cmd [args...]\n");
+  exit(1);
+}
+
+int
+main(int argc, char *argv[])
+{
+  int mask = TP_ALL;
+  int i, r, rpid, pid;
+
+  for(i = 1; i < argc && argv[i][0] == '-'; i++){
+    if(strcmp(argv[i], "-e") == 0 && i + 1 < argc)
+      mask = atoi(argv[++i]);
+    else
+      usage();
+  }
+  if(i >= argc || mask <= 0 || (mask & ~TP_ALL))
+    usage();
+
+  if((ent = malloc(MAXENT * sizeof(struct tpent))) == 0){
+    fprintf(2, "tpdump: out of memory\n");
+    exit(1);
+  }
+
+  // 丢弃之前残留的记录
+  drain();
+  nent = 0;
+  nlost = 0;
+
+  if(tpctl(mask) < 0){
+    fprintf(2, "tpdump: cannot enable tracepoints\n");
+    exit(1);
+  }
+
+  if((rpid = fork()) < 0){
+    tpctl(0);
+    fprintf(2, "tpdump: fork failed\n");
+    exit(1);
+  }
+  if(rpid == 0)
+    reader();
+
+  if((pid = fork()) < 0){
+    tpctl(0);
+    fprintf(2, "tpdump: fork failed\n");
+    exit(1);
+  }
+  if(pid == 0){
+    exec(argv[i], argv + i);
+    fprintf(2, "tpdump: exec %s failed\n", argv[i]);
+    exit(1);
+  }
+
+  while((r = wait(0)) != pid && r >= 0)
+    ;
+  tpctl(0);
+  wait(0);
+  exit(0);
+}
@@ -3,6 +3,7 @@
 #include "kernel/fcntl.h"
 #include "kernel/riscv.h"
 #include "kernel/vm.h"
+#include "kernel/clock.h"
 #include "user/user.h"
 
 //
@@ -46,14 +47,39 @@ strlen(const char *s)
   return n;
 }
 
+// memset, memmove and memcmp work a word at a time once the
+// pointers are aligned, like their kernel/string.c versions.
+#define WSIZE sizeof(uint64)
+#define WMASK (WSIZE - 1)
+
+typedef uint64 __attribute__((may_alias)) word;
+
 void*
 memset(void *dst, int c, uint n)
 {
-  char *cdst = (char *) dst;
-  int i;
-  for(i = 0; i < n; i++){
-    cdst[i] = c;
+  uchar *d = dst;
+  uint64 w;
+
+  while(n > 0 && ((uint64)d & WMASK)){
+    *d++ = c;
+    n--;
   }
+  if(n >= WSIZE){
+    w = (uchar)c;
+    w |= w << 8;
+    w |= w << 16;
+    w |= w << 32;
+    for(; n >= 4*WSIZE; n -= 4*WSIZE, d += 4*WSIZE){
+      ((word*)d)[0] = w;
+      ((word*)d)[1] = w;
+      ((word*)d)[2] = w;
+      ((word*)d)[3] = w;
+    }
+    for(; n >= WSIZE; n -= WSIZE, d += WSIZE)
+      *(word*)d = w;
+  }
+  while(n-- > 0)
+    *d++ = c;
   return dst;
 }
 
@@ -72,6 +98,9 @@ gets(char *buf, int max)
   int i, cc;
   char c;
 
+  // show any pending prompt before waiting for input.
+  if(stdio_flush)
+    stdio_flush(-1);
   for(i=0; i+1 < max; ){
     cc = read(0, &c, 1);
     if(cc < 1)
@@ -112,27 +141,65 @@ atoi(const char *s)
 void*
 memmove(void *vdst, const void *vsrc, int n)
 {
-  char *dst;
-  const char *src;
+  uchar *dst;
+  const uchar *src;
+  int aligned;
+
+  // n is signed here; a negative count has always been a
+  // no-op and must not reach the size_t word loops below.
+  if(n <= 0)
+    return vdst;
 
   dst = vdst;
   src = vsrc;
+  aligned = (((uint64)src ^ (uint64)dst) & WMASK) == 0;
   if (src > dst) {
+    if(aligned){
+      for(; n > 0 && ((uint64)dst & WMASK); n--)
+        *dst++ = *src++;
+      for(; n >= 4*WSIZE; n -= 4*WSIZE, src += 4*WSIZE, dst += 4*WSIZE){
+        ((word*)dst)[0] = ((word*)src)[0];
+        ((word*)dst)[1] = ((word*)src)[1];
+        ((word*)dst)[2] = ((word*)src)[2];
+        ((word*)dst)[3] = ((word*)src)[3];
+      }
+      for(; n >= WSIZE; n -= WSIZE, src += WSIZE, dst += WSIZE)
+        *(word*)dst = *(word*)src;
+    }
     while(n-- > 0)
       *dst++ = *src++;
   } else {
     dst += n;
     src += n;
+    if(aligned){
+      for(; n > 0 && ((uint64)dst & WMASK); n--)
+        *--dst = *--src;
+      for(; n >= WSIZE; n -= WSIZE){
+        src -= WSIZE;
+        dst -= WSIZE;
+        *(word*)dst = *(word*)src;
+      }
+    }
     while(n-- > 0)
       *--dst = *--src;
   }
   return vdst;
 }
 
+// bytes compare as unsigned char, as in kernel/string.c and
+// the C library.
 int
 memcmp(const void *s1, const void *s2, uint n)
 {
-  const char *p1 = s1, *p2 = s2;
+  const uchar *p1 = s1, *p2 = s2;
+
+  if((((uint64)p1 ^ (uint64)p2) & WMASK) == 0){
+    for(; n > 0 && ((uint64)p1 & WMASK); n--, p1++, p2++)
+      if(*p1 != *p2)
+        return *p1 - *p2;
+    for(; n >= WSIZE && *(word*)p1 == *(word*)p2; n -= WSIZE)
+      p1 += WSIZE, p2 += WSIZE;
+  }
   while (n-- > 0) {
     if (*p1 != *p2) {
       return *p1 - *p2;
@@ -159,3 +226,116 @@ sbrklazy(int n) {
   return sys_sbrk(n, SBRK_LAZY);
 }
 
+// printf.c sets this once it holds buffered output.
+// fd >= 0 flushes and forgets fd's buffer, -1 flushes all.
+// it is a pointer so programs linked without printf.o
+// (forktest) need no stdio.
+void (*stdio_flush)(int);
+
+// flush buffered output before it would be duplicated
+// (fork), lost (exec, exit), or sent to a reused fd (close).
+int
+fork(void)
+{
+  if(stdio_flush)
+    stdio_flush(-1);
+  return sys_fork();
+}
+
+int
+exec(const char *path, char **argv)
+{
+  if(stdio_flush)
+    stdio_flush(-1);
+  return sys_exec(path, argv);
+}
+
+int
+close(int fd)
+{
+  if(stdio_flush)
+    stdio_flush(fd);
+  return sys_close(fd);
+}
+
+int
+exit(int status)
+{
+  if(stdio_flush)
+    stdio_flush(-1);
+  sys_exit(status);
+}
+
+
+// the kernel enables user access to the counters
+// (scounteren), so these are plain CSR reads, not traps.
+uint64
+rdtime(void)
+{
+  uint64 x;
+  asm volatile("rdtime %0" : "=r" (x));
+  return x;
+}
+
+uint64
+rdcycle(void)
+{
+  uint64 x;
+  asm volatile("rdcycle %0" : "=r" (x));
+  return x;
+}
+
+uint64
+rdinstret(void)
+{
+  uint64 x;
+  asm volatile("rdinstret %0" : "=r" (x));
+  return x;
+}
+
+// counter frequencies, fetched from the kernel once.
+static struct clockinfo clk;
+
+static int
+clockload(void)
+{
+  if(clk.time_freq == 0 && clockinfo(&clk) < 0)
+    return -1;
+  return 0;
+}
+
+// time since boot, with the resolution of the time CSR.
+int
+clock_gettime(int clockid, struct timespec *ts)
+{
+  uint64 t;
+
+  if(clockid != CLOCK_MONOTONIC || clockload() < 0)
+    return -1;
+  t = rdtime();
+  // split before scaling so t * 1e9 cannot overflow.
+  ts->tv_sec = t / clk.time_freq;
+  ts->tv_nsec = (t % clk.time_freq) * 1000000000UL / clk.time_freq;
+  return 0;
+}
+
+// nanoseconds since boot; 0 if the clock is unavailable.
+uint64
+nsecs(void)
+{
+  struct timespec ts;
+
+  if(clock_gettime(CLOCK_MONOTONIC, &ts) < 0)
+    return 0;
+  return ts.tv_sec * 1000000000UL + ts.tv_nsec;
+}
+
+// convert a rdcycle() delta to nanoseconds.
+uint64
+cycles2ns(uint64 c)
+{
+  if(clockload() < 0 || clk.cycle_freq == 0)
+    return 0;
+  return c / clk.cycle_freq * 1000000000UL +
+         c % clk.cycle_freq * 1000000000UL / clk.cycle_freq;
+}
@@ -2,89 +2,212 @@
 #include "kernel/stat.h"
 #include "user/user.h"
 #include "kernel/param.h"
+#include "kernel/riscv.h"
 
-// Memory allocator by Kernighan and Ritchie,
-// The C programming Language, 2nd ed.  Section 8.7.
+// Size-class memory allocator.
+//
+// Small requests are rounded up to a power-of-two block size
+// (32 to 4096 bytes, counting a 16-byte header) and served
+// from a per-class free list, or failing that by bumping a
+// per-class pointer through a page carved from the arena.
+// Both malloc and free are O(1) and blocks are never split
+// or merged.
+//
+// Larger requests get whole pages from sbrklazy(), so memory
+// the program never touches is never allocated. Freed large
+// regions go on an address-ordered first-fit list and merge
+// with their neighbours; a region that ends at the program
+// break is handed back with sbrk(-n).
+//
+// every block starts with a header holding its class, or
+// LARGE and the region size in pages for large blocks. the
+// header is padded to 16 bytes: blocks start on multiples of
+// their size (or on a page), so every pointer malloc returns
+// is 16-byte aligned, as the RISC-V psABI expects.
 
-typedef long Align;
+#define MINSHIFT 5                  // smallest block is 32 bytes
+#define NCLASS   8                  // 32, 64, ..., 4096
+#define MAXSMALL (1 << (MINSHIFT + NCLASS - 1))
+#define LARGE    0xff
+#define ARENA    (16 * PGSIZE)      // small-block arena growth step
 
-union header {
-  struct {
-    union header *ptr;
-    uint size;
-  } s;
-  Align x;
+typedef struct header {
+  uint64 cls : 8;                   // size class, or LARGE
+  uint64 npages : 56;               // LARGE: pages in the region
+} __attribute__((aligned(16))) Header;
+
+struct block {                      // a free small block
+  struct block *next;
 };
 
-typedef union header Header;
+struct region {                     // a free large region
+  struct region *next;
+  uint64 npages;
+};
 
-static Header base;
-static Header *freep;
+static struct block *freelist[NCLASS];
+static char *bump[NCLASS], *bumpend[NCLASS];
+static char *arena, *arenaend;
+static struct region *bigfree;
 
-void
-free(void *ap)
+// class whose blocks hold n bytes plus the header.
+static int
+sizeclass(uint n)
 {
-  Header *bp, *p;
-
-  bp = (Header*)ap - 1;
-  for(p = freep; !(bp > p && bp < p->s.ptr); p = p->s.ptr)
-    if(p >= p->s.ptr && (bp > p || bp < p->s.ptr))
-      break;
-  if(bp + bp->s.size == p->s.ptr){
-    bp->s.size += p->s.ptr->s.size;
-    bp->s.ptr = p->s.ptr->s.ptr;
-  } else
-    bp->s.ptr = p->s.ptr;
-  if(p + p->s.size == bp){
-    p->s.size += bp->s.size;
-    p->s.ptr = bp->s.ptr;
-  } else
-    p->s.ptr = bp;
-  freep = p;
+  uint sz = 1 << MINSHIFT;
+  int c = 0;
+
+  n += sizeof(Header);
+  while(sz < n){
+    sz <<= 1;
+    c++;
+  }
+  return c;
 }
 
-static Header*
-morecore(uint nu)
+// grow the heap by n bytes, a multiple of PGSIZE. the
+// first call pads the break to a page boundary, after which
+// every region starts on a page.
+static char*
+morecore(uint64 n, int lazy)
+{
+  uint64 brk = (uint64)sbrklazy(0);
+
+  if(brk % PGSIZE && sbrk(PGROUNDUP(brk) - brk) == SBRK_ERROR)
+    return SBRK_ERROR;
+  return lazy ? sbrklazy(n) : sbrk(n);
+}
+
+// hand a fresh page of blocks to class c.
+static int
+refill(int c)
 {
   char *p;
-  Header *hp;
 
-  if(nu < 4096)
-    nu = 4096;
-  p = sbrk(nu * sizeof(Header));
-  if(p == SBRK_ERROR)
-    return 0;
-  hp = (Header*)p;
-  hp->s.size = nu;
-  free((void*)(hp + 1));
-  return freep;
+  if(arena == arenaend){
+    if((p = morecore(ARENA, 0)) == SBRK_ERROR)
+      return -1;
+    arena = p;
+    arenaend = p + ARENA;
+  }
+  bump[c] = arena;
+  bumpend[c] = arena + PGSIZE;
+  arena += PGSIZE;
+  return 0;
 }
 
-void*
-malloc(uint nbytes)
+static void*
+smallalloc(int c)
 {
-  Header *p, *prevp;
-  uint nunits;
+  Header *h;
+  struct block *b;
 
-  nunits = (nbytes + sizeof(Header) - 1)/sizeof(Header) + 1;
-  if((prevp = freep) == 0){
-    base.s.ptr = freep = prevp = &base;
-    base.s.size = 0;
+  if((b = freelist[c]) != 0){
+    freelist[c] = b->next;
+    h = (Header*)b;
+  } else {
+    if(bump[c] == bumpend[c] && refill(c) < 0)
+      return 0;
+    h = (Header*)bump[c];
+    bump[c] += 1 << (MINSHIFT + c);
   }
-  for(p = prevp->s.ptr; ; prevp = p, p = p->s.ptr){
-    if(p->s.size >= nunits){
-      if(p->s.size == nunits)
-        prevp->s.ptr = p->s.ptr;
-      else {
-        p->s.size -= nunits;
-        p += p->s.size;
-        p->s.size = nunits;
-      }
-      freep = prevp;
-      return (void*)(p + 1);
+  h->cls = c;
+  return h + 1;
+}
+
+static void*
+largealloc(uint nbytes)
+{
+  uint64 npages = PGROUNDUP(nbytes + sizeof(Header)) / PGSIZE;
+  struct region *r, **rp;
+  Header *h;
+
+  for(rp = &bigfree; (r = *rp) != 0; rp = &r->next){
+    if(r->npages < npages)
+      continue;
+    if(r->npages == npages){
+      *rp = r->next;
+    } else {
+      // carve from the tail, leaving the head on the list.
+      r->npages -= npages;
+      r = (struct region*)((char*)r + r->npages * PGSIZE);
     }
-    if(p == freep)
-      if((p = morecore(nunits)) == 0)
-        return 0;
+    h = (Header*)r;
+    goto found;
+  }
+
+  h = (Header*)morecore(npages * PGSIZE, 1);
+  if(h == (Header*)SBRK_ERROR)
+    return 0;
+
+found:
+  h->cls = LARGE;
+  h->npages = npages;
+  return h + 1;
+}
+
+// the free list is kept in address order so neighbouring
+// regions merge. this is O(free regions), but large frees
+// are rare next to the small-block traffic.
+static void
+largefree(Header *h)
+{
+  struct region *r = (struct region*)h;
+  struct region *prev = 0, *next;
+
+  r->npages = h->npages;
+  for(next = bigfree; next && next < r; next = next->next)
+    prev = next;
+
+  if(next && (char*)r + r->npages * PGSIZE == (char*)next){
+    r->npages += next->npages;
+    next = next->next;
   }
+  r->next = next;
+  if(prev && (char*)prev + prev->npages * PGSIZE == (char*)r){
+    prev->npages += r->npages;
+    prev->next = r->next;
+    r = prev;
+  } else if(prev){
+    prev->next = r;
+  } else {
+    bigfree = r;
+  }
+
+  // give the top of the heap back to the kernel.
+  if(r->next == 0 && (char*)r + r->npages * PGSIZE == sbrklazy(0)){
+    struct region **rp;
+    for(rp = &bigfree; *rp != r; rp = &(*rp)->next)
+      ;
+    *rp = 0;
+    sbrk(-(r->npages * PGSIZE));
+  }
+}
+
+void
+free(void *ap)
+{
+  Header *h;
+  struct block *b;
+  int c;
+
+  if(ap == 0)
+    return;
+  h = (Header*)ap - 1;
+  if((c = h->cls) == LARGE){
+    largefree(h);
+    return;
+  }
+  // the link overwrites the header.
+  b = (struct block*)h;
+  b->next = freelist[c];
+  freelist[c] = b;
+}
+
+void*
+malloc(uint nbytes)
+{
+  if(nbytes <= MAXSMALL - sizeof(Header))
+    return smallalloc(sizeclass(nbytes));
+  return largealloc(nbytes);
 }
@@ -1,6 +1,27 @@
 #define SBRK_ERROR ((char *)-1)
 
+#define CLOCK_MONOTONIC 1
+
+// stdio buffering modes, see setvbuf().
+#define _IOFBF 0    // fully buffered: files and pipes
+#define _IOLBF 1    // line buffered: the console
+#define _IONBF 2    // unbuffered: fd 2, flushed after each call
+
 struct stat;
+struct clockinfo;
+struct sysop;
+struct traceent;
+struct klogent;
+struct profent;
+struct faultstat;
+struct sysinfo;
+struct tpent;
+struct perfstat;
+
+struct timespec {
+  uint64 tv_sec;
+  uint64 tv_nsec;
+};
 
 // system calls
 int fork(void);
@@ -24,12 +45,34 @@ int chdir(const char*);
 int dup(int);
 int getpid(void);
 char* sys_sbrk(int,int);
+int sys_fork(void);
+int sys_exit(int) __attribute__((noreturn));
+int sys_exec(const char*, char**);
+int sys_close(int);
 int pause(int);
 int uptime(void);
 int setpriority(int, int);
 int getpriority(int);
 int geterrno(void);
 int set_scheduler(int);
+int clockinfo(struct clockinfo*);
+int syscall_batch(struct sysop*, int);
+int trace(uint64);
+int traceread(struct traceent*, int, uint64*);
+int dmesg(struct klogent*, int);
+int fdlimit(int);
+int setpgid(int, int);
+int getpgid(int);
+int setsid(void);
+int killpg(int);
+int prof(int);
+int profread(struct profent*, int, uint64*);
+int faultstat(int, struct faultstat*);
+int sysinfo(struct sysinfo*, int);
+int tpctl(int);
+int tpread(struct tpent*, int, uint64*);
+int perf_stat(int, struct perfstat*);
+int yield(void);
 
 // ulib.c
 int stat(const char*, struct stat*);
@@ -45,10 +88,20 @@ int memcmp(const void *, const void *, uint);
 void *memcpy(void *, const void *, uint);
 char* sbrk(int);
 char* sbrklazy(int);
+extern void (*stdio_flush)(int);
+uint64 rdtime(void);
+uint64 rdcycle(void);
+uint64 rdinstret(void);
+int clock_gettime(int, struct timespec*);
+uint64 nsecs(void);
+uint64 cycles2ns(uint64);
 
 // printf.c
 void fprintf(int, const char*, ...) __attribute__ ((format (printf, 2, 3)));
 void printf(const char*, ...) __attribute__ ((format (printf, 1, 2)));
+void fputc(int, char);
+int fflush(int);
+int setvbuf(int, int);
 
 // umalloc.c
 void* malloc(uint);
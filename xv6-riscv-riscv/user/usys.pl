@@ -9,7 +9,7 @@ print "#include \"kernel/syscall.h\"\n";
 sub entry {
     my $prefix = "sys_";
     my $name = shift;
-    if ($name eq "sbrk") {
+    if ($name =~ /^(sbrk|exit|fork|exec|close)$/) {
 	print ".global $prefix$name\n";
 	print "$prefix$name:\n";
     } else {
@@ -48,3 +48,21 @@ entry("geterrno");
 entry("set_scheduler");
 entry("symlink");
 entry("readlink");
+entry("clockinfo");
+entry("syscall_batch");
+entry("trace");
+entry("traceread");
+entry("dmesg");
+entry("fdlimit");
+entry("setpgid");
+entry("getpgid");
+entry("setsid");
+entry("killpg");
+entry("prof");
+entry("profread");
+entry("faultstat");
+entry("sysinfo");
+entry("tpctl");
+entry("tpread");
+entry("perf_stat");
+entry("yield");